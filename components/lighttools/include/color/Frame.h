@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include "../export.h"
+#include "RGB.h"
+
+
+namespace Color
+{
+
+// Whole frame color kernels
+//
+// These combine a frame of source pixels into a destination frame of the same
+// length, or fade a frame in place.  They work on the packed rgb32_t, two 8 bit channels at a time in
+// 16 bit lanes of a 32 bit word, so they cost a few integer operations per
+// pixel rather than a multiply and divide per channel.
+//
+// alpha is the strength of the source, 0 - 256 with 256 the full source.
+
+// alpha for an 8 bit level, 255 is the full source
+inline uint16_t Alpha( uint8_t level )
+{
+    return level + ( level >> 7 );
+}
+
+// dst = src over dst
+LIGHTTOOLS_API void OverFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha = 256 );
+
+// dst = dst + src, saturating
+LIGHTTOOLS_API void AddFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha = 256 );
+
+// dst = the brighter of dst and src, for each channel
+LIGHTTOOLS_API void MaxFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha = 256 );
+
+// dst = dst * src, with 255 as 1
+LIGHTTOOLS_API void MultiplyFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha = 256 );
+
+// ColorFade() of each pixel, giving the same result
+LIGHTTOOLS_API void FadeFrame( std::span< rgb32_t > pixels, uint8_t level );
+
+// mix each pixel with its neighbours, amount 0 - 255, 255 is about equal parts
+// of each, the pixels past the ends count as the end pixels
+LIGHTTOOLS_API void BlurFrame( std::span< rgb32_t > pixels, uint8_t amount );
+
+// dst = ColorBlend() of each pixel of from and to, giving the same result, dst
+// can be either source
+LIGHTTOOLS_API void BlendFrames( std::span< rgb32_t > dst, std::span< const rgb32_t > from,
+    std::span< const rgb32_t > to, uint8_t level );
+
+} // namespace Color
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include "../export.h"
+#include "RGB.h"
+
+
+namespace Color
+{
+
+#pragma pack( push, 1 )
+// HSV packed into 32 bits, from MSB to LSB: unused, H, S, V
+// Hue goes once around the color wheel over 0 - 255, red at 0 as ColorWheel()
+struct hsv32_t
+{
+    hsv32_t( uint8_t h = 0, uint8_t s = 255, uint8_t v = 255 )
+    {
+        setAll( h, s, v );
+    }
+
+    uint8_t h( ) const
+    {
+        return ( packed >> 16 ) & 0xff;
+    }
+
+    void setH( uint8_t h )
+    {
+        packed = ( packed & 0xff00ffff ) + ( h << 16 );
+    }
+
+    uint8_t s( ) const
+    {
+        return ( packed >> 8 ) & 0xff;
+    }
+
+    void setS( uint8_t s )
+    {
+        packed = ( packed & 0xffff00ff ) + ( s << 8 );
+    }
+
+    uint8_t v( ) const
+    {
+        return packed & 0xff;
+    }
+
+    void setV( uint8_t v )
+    {
+        packed = ( packed & 0xffffff00 ) + v;
+    }
+
+    void setAll( uint8_t h = 0, uint8_t s = 255, uint8_t v = 255 )
+    {
+        packed = ( h << 16 ) + ( s << 8 ) + v;
+    }
+
+    uint32_t packed;
+
+    operator uint32_t( ) const
+    {
+        return packed;
+    }
+};
+#pragma pack( pop )
+
+// the color of a hue at full saturation and value, worked out with a multiply
+// and table lookups rather than branches and a divide
+LIGHTTOOLS_API rgb32_t HueToRgb( uint8_t hue );
+
+// the color of every hue at full saturation and value, built on first use
+LIGHTTOOLS_API const Palette& HuePalette( );
+
+// HSV to RGB, desaturating towards white then scaling by value
+LIGHTTOOLS_API rgb32_t HsvToRgb( hsv32_t hsv );
+
+// HSV to RGB with the hue looked up in hues, eg HuePalette()
+LIGHTTOOLS_API rgb32_t HsvToRgb( hsv32_t hsv, const Palette& hues );
+
+// a frame of HSV to RGB, hues looked up in hues if given, otherwise worked out
+LIGHTTOOLS_API void HsvToRgb( std::span< const hsv32_t > hsv, std::span< rgb32_t > rgb,
+    const Palette *hues = nullptr );
+
+} // namespace Color
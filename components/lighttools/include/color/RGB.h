@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
 #include <array>
 #include "../export.h"
 
@@ -172,7 +173,72 @@ struct wrgb32_t
 #pragma pack( pop )
 
 
+// Splits RGB colors into RGBW, for strips with a white emitter
+//
+// The white emitter is described by the RGB levels whose mix matches it, so
+// each pixel moves the largest amount of that mix it contains onto W.  This
+// runs on every pixel of every frame, so it's kept to integer multiplies and
+// shifts with the reciprocals worked out up front.
+class LIGHTTOOLS_API WhiteExtractor
+{
+public:
+    // white is the RGB mix matching the white emitter at full
+    WhiteExtractor( rgb32_t white = rgb32_t::White( ) )
+    {
+        setWhite( white );
+    }
+
+    // the RGB mix matching the white emitter at full
+    rgb32_t white( ) const
+    {
+        return rgb32_t( m_mix[ 0 ], m_mix[ 1 ], m_mix[ 2 ] );
+    }
+
+    // the RGB mix matching the white emitter at full
+    void setWhite( rgb32_t white )
+    {
+        const uint8_t mix[ 3 ] = { white.r( ), white.g( ), white.b( ) };
+        for ( int i = 0; i < 3; ++i )
+        {
+            m_mix[ i ] = mix[ i ];
+            // 8.8 fixed point 255 / mix, channels not in the mix don't limit white
+            m_inverse[ i ] = mix[ i ] ? ( 255 * 256 / mix[ i ] ) : UINT16_MAX;
+        }
+        if ( white == 0 )
+        {
+            // no mix, no white
+            m_inverse[ 0 ] = m_inverse[ 1 ] = m_inverse[ 2 ] = 0;
+        }
+    }
+
+    // split a color into RGBW
+    wrgb32_t extract( rgb32_t color ) const
+    {
+        uint32_t r = color.r( ), g = color.g( ), b = color.b( );
+
+        // the most white that fits inside the color
+        uint32_t w = std::min( { ( r * m_inverse[ 0 ] ) >> 8, ( g * m_inverse[ 1 ] ) >> 8,
+            ( b * m_inverse[ 2 ] ) >> 8, 255u } );
+
+        // and take it out of the RGB, w fits in each channel so none go negative
+        r -= w * m_mix[ 0 ] / 255;
+        g -= w * m_mix[ 1 ] / 255;
+        b -= w * m_mix[ 2 ] / 255;
+        return wrgb32_t( r, g, b, w );
+    }
+
+private:
+    uint32_t m_mix[ 3 ];
+    uint32_t m_inverse[ 3 ];
+};
+
+// Colors looked up by an 8 bit position, eg a Gradient's
+typedef std::array< rgb32_t, 256 > Palette;
+
 // Calculates RGB color gradient values
+//
+// The colors at every position are kept in a palette that's rebuilt whenever
+// the steps change, so a lookup is a single load.
 class LIGHTTOOLS_API Gradient
 {
 public:
@@ -186,31 +252,40 @@ public:
 
     void clearSteps( );
     void addStep( uint8_t pos, rgb32_t color );
-    void setSteps( Step *st, uint8_t steps );
 
-    rgb32_t getColor( uint8_t pos );
+    // replace the steps, the palette is only rebuilt if they're different
+    void setSteps( const Step *st, uint8_t steps );
 
-/*
-    void smear();
-    void randomize();
-    void randomize(int, int); // set low and high range
-    void peturb(int, int);
-    void fade();
-    void wipe(byte level);
-*/
+    rgb32_t getColor( uint8_t pos ) const
+    {
+        return m_palette[ pos ];
+    }
+
+    // the color at every position
+    const Palette& palette( ) const
+    {
+        return m_palette;
+    }
 
 private:
+    // the color at a position, worked out from the steps
+    rgb32_t interpolate( uint8_t pos ) const;
+
+    // work out the palette from the steps
+    void rebuild( );
+
     std::array< Step, 10> m_steps;
     uint8_t m_stepCount;
+    Palette m_palette;
 };
 
 // Color tools
 
-// generic 8 bit fader
+// generic 8 bit fader, low at 0 to high at 255, rounded towards low
 inline uint8_t fade( uint8_t low, uint8_t high, uint8_t v )
 {
-    // promote to 32 bits to ensure enough range to handle multiplication
-    return ( static_cast< uint32_t >( high ) - low ) * v / 255 + low;
+    // signed, so fading down rounds the same way as fading up
+    return low + ( static_cast< int >( high ) - low ) * v / 255;
 }
 
 // decrease intensity by value (0-255)
@@ -219,11 +294,12 @@ rgb32_t LIGHTTOOLS_API ColorFade( rgb32_t color, uint8_t value );
 // crossfade between colors
 rgb32_t LIGHTTOOLS_API ColorBlend( rgb32_t color1, rgb32_t color2, uint8_t value );
 
-// random color
-rgb32_t LIGHTTOOLS_API ColorRandom( );
+// saturated color picked by a random number from the caller, eg a
+// Pattern::Random draw, so nodes with the same seed pick the same color
+rgb32_t LIGHTTOOLS_API ColorRandom( uint32_t random );
 
 // Input a value 0 to 255 to get a color value.
-// The colours are a transition r - g - b - back to r.
+// The colours are a transition r - g - b - back to r, see HuePalette().
 rgb32_t LIGHTTOOLS_API ColorWheel( uint8_t WheelPos );
 
 } // namespace Color
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include "CIEXYZ.h"
+#include "RGB.h"
+
+
+namespace Color
+{
+
+// Works out the WhiteExtractor mix from measured emitter chromaticities
+//
+// primaries are the red, green and blue emitters and white is the white
+// emitter, each with its luminance at full.  The result is the RGB mix that
+// matches the white emitter's chromaticity, scaled to its luminance where the
+// RGB can reach it.  Returns no mix, ie no white extraction, if the white is
+// outside the RGB gamut.
+template< typename T >
+WhiteExtractor WhiteFromEmitters( std::array< CIEXYZ::xyY< T >, 3 > primaries, CIEXYZ::xyY< T > white )
+{
+    // the primaries at unit luminance are the columns, solve for the
+    // luminance of each that adds up to the white
+    CIEXYZ::XYZ< T > m[ 3 ];
+    for ( int i = 0; i < 3; ++i )
+    {
+        m[ i ] = CIEXYZ::XYZ< T >( CIEXYZ::xyY< T >( primaries[ i ].x, primaries[ i ].y, 1 ) );
+    }
+    const CIEXYZ::XYZ< T > target( white );
+
+    auto det = []( const CIEXYZ::XYZ< T >& a, const CIEXYZ::XYZ< T >& b, const CIEXYZ::XYZ< T >& c )
+    {
+        return a.X * ( b.Y * c.Z - b.Z * c.Y ) - b.X * ( a.Y * c.Z - a.Z * c.Y ) + c.X * ( a.Y * b.Z - a.Z * b.Y );
+    };
+    const T d( det( m[ 0 ], m[ 1 ], m[ 2 ] ) );
+    if ( d == 0 )
+    {
+        return WhiteExtractor( 0 );
+    }
+    const T levels[ 3 ] = {
+        det( target, m[ 1 ], m[ 2 ] ) / d,
+        det( m[ 0 ], target, m[ 2 ] ) / d,
+        det( m[ 0 ], m[ 1 ], target ) / d };
+    if ( levels[ 0 ] < 0 || levels[ 1 ] < 0 || levels[ 2 ] < 0 )
+    {
+        // the white is outside the RGB gamut
+        return WhiteExtractor( 0 );
+    }
+
+    // levels match the white emitter, dim the mix to the brightest the RGB can
+    // reach if any primary would need to go past full
+    T scale( 1 );
+    for ( int i = 0; i < 3; ++i )
+    {
+        if ( levels[ i ] > primaries[ i ].Y )
+        {
+            scale = std::min( scale, primaries[ i ].Y / levels[ i ] );
+        }
+    }
+
+    uint8_t mix[ 3 ];
+    for ( int i = 0; i < 3; ++i )
+    {
+        T level( primaries[ i ].Y ? ( levels[ i ] * scale / primaries[ i ].Y ) : 0 );
+        mix[ i ] = static_cast< uint8_t >( std::clamp< T >( level * 255 + T( 0.5 ), 0, 255 ) );
+    }
+    return WhiteExtractor( rgb32_t( mix[ 0 ], mix[ 1 ], mix[ 2 ] ) );
+}
+
+} // namespace Color
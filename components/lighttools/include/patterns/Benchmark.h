@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../export.h"
+#include "BufferStrip.h"
+#include "Pattern.h"
+
+
+namespace Pattern
+{
+
+// Times patterns from CreatePattern() through Init(), Loop() and Update()
+//
+// Patterns render into a BufferStrip at simulated time, a frame each refresh
+// period.  Time is measured by a clock given by the caller, in whatever ticks it
+// counts, so the same runs can be timed in ns on the host and in cycles on the
+// ESP32 and the two compared.
+class LIGHTTOOLS_API Benchmark
+{
+public:
+    typedef uint64_t ( *Clock )( );
+
+    // what to run
+    struct Case
+    {
+        uint8_t pattern;
+        uint16_t pixels;
+        uint8_t speed;
+        uint8_t level;  // level[0]
+    };
+
+    // clock ticks taken
+    struct Result
+    {
+        Case test;
+        uint32_t frames;    // frames after Init()
+        uint64_t init;      // ticks for Init()
+        uint64_t render;    // ticks for all the frames after Init()
+
+        double perFrame( ) const
+        {
+            return frames ? double( render ) / frames : 0;
+        }
+
+        double perPixel( ) const
+        {
+            return test.pixels ? perFrame( ) / test.pixels : 0;
+        }
+    };
+
+    // the standard settings to run each pattern with
+    static constexpr uint16_t Sizes[] = { 60, 300, 1000, 4096 };
+    static constexpr uint8_t Speeds[] = { 35, 100, 255 };
+    static constexpr uint8_t Levels[] = { 8, 128, 255 };
+
+    Benchmark( Clock clock, ms_t period = 25 )
+        : m_clock( clock ), m_period( period )
+    {
+    }
+
+    // true if the pattern can be run, ie it's built in or its program is loaded
+    static bool available( uint8_t pattern );
+
+    // run a pattern for a number of frames
+    Result run( const Case& test, uint32_t frames );
+
+    // run each available pattern at each standard size, speed and level, calling report( Result )
+    template< typename Fn >
+    void runAll( uint32_t frames, Fn report )
+    {
+        for ( int pattern = 0; pattern < Bytecode + ProgramStore::Slots; ++pattern )
+        {
+            if ( !available( pattern ) )
+            {
+                continue;
+            }
+            for ( auto pixels : Sizes )
+            {
+                for ( auto speed : Speeds )
+                {
+                    for ( auto level : Levels )
+                    {
+                        report( run( { uint8_t( pattern ), pixels, speed, level }, frames ) );
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    Clock m_clock;
+    ms_t m_period;
+    std::vector< uint8_t > m_scratch;
+};
+
+} // namespace Pattern
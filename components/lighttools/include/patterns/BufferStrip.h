@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+#include "../export.h"
+#include "Strip.h"
+
+
+namespace Pattern
+{
+
+// Strip that keeps its pixels in memory
+//
+// This is the base for strips that drive hardware, and can be used on its own
+// wherever a Strip is needed without any LEDs attached, for example as a mock
+// output channel.  On its own transmit() only reports the frame as done.
+class LIGHTTOOLS_API BufferStrip : public Strip
+{
+public:
+    BufferStrip( uint16_t size = 0 )
+        : m_pixels( size )
+    {
+    }
+
+    // returns the number of pixels
+    virtual uint16_t numPixels( ) const override
+    {
+        return m_pixels.size( );
+    }
+
+    // get a pixel color value
+    virtual Color::rgb32_t getPixelColor( uint16_t pixel ) const override
+    {
+        return m_pixels[ pixel ];
+    }
+
+    // set a single pixel to a color
+    virtual void setPixelColor( uint16_t pixel, Color::rgb32_t color ) override
+    {
+        if ( m_pixels[ pixel ] != color )
+        {
+            m_pixels[ pixel ] = color;
+            markDirty( pixel, 1 );
+        }
+    }
+
+    // direct access to the pixels
+    virtual std::span< Color::rgb32_t > pixels( ) override
+    {
+        return m_pixels;
+    }
+
+    // set count pixels starting at first to a color
+    virtual void fillRange( uint16_t first, uint16_t count, Color::rgb32_t color ) override;
+
+    // copy count pixels starting at src to dst, the ranges may overlap
+    virtual void copyRange( uint16_t dst, uint16_t src, uint16_t count ) override
+    {
+        std::memmove( m_pixels.data( ) + dst, m_pixels.data( ) + src, count * sizeof( Color::rgb32_t ) );
+        markDirty( dst, count );
+    }
+
+    // set pixels starting at first to colors
+    virtual void writePixels( std::span< const Color::rgb32_t > colors, uint16_t first = 0 ) override;
+
+    // independent control of brightness
+    virtual uint8_t getBrightness( ) const override
+    {
+        return m_brightness;
+    }
+
+    // independent control of brightness
+    virtual void setBrightness( uint8_t bright ) override
+    {
+        if ( m_brightness != bright )
+        {
+            m_brightness = bright;
+            markDirty( );
+        }
+    }
+
+    // send the buffered pixel data to the hardware
+    virtual void transmit( ) override
+    {
+        if ( startFrame( ) )
+        {
+            clearDirty( );
+        }
+        transmitDone( );
+    }
+
+protected:
+    // change the number of pixels, new pixels are black
+    void resize( uint16_t size )
+    {
+        m_pixels.resize( size );
+    }
+
+    std::vector< Color::rgb32_t > m_pixels;
+    uint8_t m_brightness = 255;
+};
+
+} // namespace Pattern
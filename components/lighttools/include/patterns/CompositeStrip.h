@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "../export.h"
+#include "BufferStrip.h"
+
+
+namespace Pattern
+{
+
+// Joins segments of several output channels into one strip
+//
+// Patterns see one long strip made of the segments end to end, in the order
+// they were added.  Each segment is a run of pixels on a channel, which may be
+// wired in reverse.  On transmit the segments are copied out to their channels
+// and all channels are started together, so a frame takes as long as the
+// longest channel rather than the total pixel count.  Every channel is sent
+// for every composite frame, even one whose segments didn't change, so the
+// completed frame callback fires once all of them call back.
+class LIGHTTOOLS_API CompositeStrip : public BufferStrip
+{
+public:
+    struct Segment
+    {
+        Strip *channel;     // the output carrying these pixels
+        uint16_t offset;    // first channel pixel in the segment
+        uint16_t length;    // number of pixels in the segment
+        bool reversed;      // true if the segment runs from the end back to offset
+    };
+
+    // add a segment after the existing pixels
+    void addSegment( const Segment& segment );
+
+    // returns the channel and channel pixel for a pixel, or nullptr if out of range
+    std::pair< Strip *, uint16_t > map( uint16_t pixel ) const;
+
+    // independent control of brightness, applied to all channels
+    virtual void setBrightness( uint8_t bright ) override;
+
+    // send the buffered pixel data to the hardware
+    virtual void transmit( ) override;
+
+    // start sending to all channels without waiting for them to complete
+    virtual void transmitAsync( ) override;
+
+    // wait for all channels to complete
+    virtual bool waitTransmit( uint32_t timeout ) override;
+
+    // estimated time to send a frame, ie the slowest channel
+    virtual uint32_t transmitTime( ) const override;
+
+protected:
+    // copy pixels out to the channels
+    void copyToChannels( );
+
+    // called as each channel completes
+    static void channelDone( void *strip );
+
+    std::vector< Segment > m_segments;
+    std::vector< Strip * > m_channels; // each channel once
+    std::atomic< int > m_pending{ 0 }; // channels still transmitting
+};
+
+} // namespace Pattern
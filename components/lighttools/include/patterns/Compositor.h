@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "../export.h"
+#include "BufferStrip.h"
+#include "Player.h"
+
+
+namespace Pattern
+{
+
+// Plays several patterns at once as layers and combines them onto one Strip
+//
+// Each layer has its own Player and control, and renders into its own buffer.
+// Each frame the layers are combined in order, from the bottom layer up, each
+// with its blend mode, and the result is written to the strip.  The layer
+// intensity in the control is its opacity, the strip's own brightness is left
+// to the caller.  Buffers are sized on first use and kept, so compositing
+// doesn't touch the heap once running.
+class LIGHTTOOLS_API Compositor
+{
+public:
+    // how a layer combines with the layers below it
+    enum class Blend : uint8_t
+    {
+        Over,       // replaces the layers below
+        Add,        // adds to them, saturating
+        Max,        // the brighter of each channel
+        Multiply,   // scales them, white leaves them as they are
+    };
+
+    Compositor( size_t layers );
+
+    // number of layers
+    size_t layerCount( ) const
+    {
+        return m_layers.size( );
+    }
+
+    //! update a layer with a new pattern, and/or changed pattern parameters
+    void UpdateLayer( size_t layer, ms_t now, const PlayerControl& control, Blend blend, Strip *strip );
+
+    //! stop playing a layer
+    void ClearLayer( size_t layer );
+
+    //! update the strip with all the layers
+    void UpdateStrip( ms_t now, Strip *strip );
+
+protected:
+    struct Layer
+    {
+        Player player;
+        BufferStrip pixels; // what the layer renders, brightness is the opacity
+        Blend blend = Blend::Over;
+        bool active = false;
+    };
+
+    std::vector< Layer > m_layers;
+    std::vector< Color::rgb32_t > m_frame; // the combined layers
+    bool m_changed = true; // layers were added, removed or reordered since the last frame
+};
+
+} // namespace Pattern
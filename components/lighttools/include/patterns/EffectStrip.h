@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+#include "../export.h"
+#include "BufferStrip.h"
+
+
+namespace Pattern
+{
+
+// A post processing stage, run on each frame on its way to the LEDs
+struct Effect
+{
+    enum Type : uint8_t
+    {
+        None,
+        Mirror,     // the frame then its reflection, patterns render half the pixels
+        Reverse,    // the frame end to end
+        Repeat,     // the first amount pixels tiled along the frame, patterns render amount pixels
+        Blur,       // each pixel mixed with its neighbours by amount, 0 - 255
+        Decay,      // trails, lit pixels fade by amount / 255 each frame rather than going out, 1 - 255
+    };
+
+    Type type = None;
+    uint16_t amount = 0;
+};
+
+// Strip that runs a chain of effects on each frame, then sends it to an output strip
+//
+// Patterns render into this strip, which can be shorter than the output: each
+// Mirror halves it and each Repeat cuts it down to the segment length.  On
+// transmit the frame is copied to the start of the output's pixels, and each
+// effect in turn works in place there, growing the frame back out to the full
+// length.  Only Decay keeps anything between frames, the last frame as it was
+// at that stage.
+//
+// Changing the effects can change the number of pixels, so set them before
+// starting patterns on the strip.  A PixelMap describes the output's pixels,
+// so it only carries over when no effect shrinks the strip; with Mirror or
+// Repeat the patterns render along the strip instead.
+class LIGHTTOOLS_API EffectStrip : public BufferStrip
+{
+public:
+    static constexpr size_t MaxEffects = 8;
+
+    EffectStrip( Strip *output );
+
+    // the strip the processed frames go to
+    Strip *output( ) const
+    {
+        return m_output;
+    }
+
+    // the effects, in the order they run
+    std::span< const Effect > effects( ) const
+    {
+        return std::span< const Effect >( m_effects.data( ), m_effectCount );
+    }
+
+    // replace the effects, up to MaxEffects, resizing the strip to the pixels patterns render
+    void setEffects( std::span< const Effect > effects );
+
+    // independent control of brightness, applied to the output
+    virtual void setBrightness( uint8_t bright ) override;
+
+    // process the frame and send it
+    virtual void transmit( ) override;
+
+    // process the frame and start sending it without waiting for it to complete
+    virtual void transmitAsync( ) override;
+
+    // wait for the output to complete
+    virtual bool waitTransmit( uint32_t timeout ) override;
+
+    // estimated time to send a frame to the output
+    virtual uint32_t transmitTime( ) const override;
+
+protected:
+    // run the effects on a frame, the rendered pixels are already at the start of frame
+    void process( std::span< Color::rgb32_t > frame );
+
+    // called when the output completes
+    static void outputDone( void *strip );
+
+    Strip *m_output;
+    std::array< Effect, MaxEffects > m_effects;
+    size_t m_effectCount = 0;
+    std::array< uint16_t, MaxEffects + 1 > m_sizes; // frame length before each effect, then the output length
+    std::vector< Color::rgb32_t > m_frame; // the processed frame, when the output doesn't keep its pixels
+    std::vector< Color::rgb32_t > m_trail; // the last frame, for Decay
+    bool m_fading = false; // true while trails still show over the frame
+};
+
+} // namespace Pattern
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdio>
+#include <span>
+#include <vector>
+#include "../export.h"
+#include "BufferStrip.h"
+#include "Pattern.h"
+
+
+namespace Pattern
+{
+
+// Strip that records transmitted frames, for running patterns without hardware
+//
+// Each transmitted frame is kept in memory with its timestamp, and can also be
+// streamed to a file as it's transmitted.  Frames are stored as 3 bytes per pixel
+// in R, G, B order with the strip brightness alongside, not applied.
+//
+// File layout, all values little endian:
+//   header: "RPXF", uint16 version, uint16 pixels, uint32 frame count, uint32 index offset
+//   frames: uint32 time (ms), uint8 brightness, pixels * RGB
+//   index:  frame count * ( uint32 time, uint32 file offset of the frame )
+// Frames skipped as unchanged (see setSkipUnchanged()) aren't recorded.
+class LIGHTTOOLS_API HostStrip : public BufferStrip
+{
+public:
+    static constexpr uint16_t FileVersion = 1;
+
+    // maxFrames limits the frames kept in memory, older frames are dropped
+    HostStrip( uint16_t size, size_t maxFrames = SIZE_MAX );
+
+    ~HostStrip( );
+
+    // time stamp for frames transmitted from now on
+    void setTime( ms_t now )
+    {
+        m_now = now;
+    }
+
+    // record the current frame
+    virtual void transmit( ) override;
+
+    // number of frames in memory
+    size_t frameCount( ) const
+    {
+        return m_times.size( );
+    }
+
+    // time stamp of a frame in memory
+    ms_t frameTime( size_t frame ) const
+    {
+        return m_times[ frame ];
+    }
+
+    // RGB bytes of a frame in memory
+    std::span< const uint8_t > frame( size_t frame ) const
+    {
+        return std::span< const uint8_t >( m_frames ).subspan( frame * frameSize( ), frameSize( ) );
+    }
+
+    // forget the frames in memory
+    void clearFrames( );
+
+    // start streaming frames to a file, returns false if it couldn't be created
+    bool record( const char *path );
+
+    // finish the file being streamed, writing the index
+    bool close( );
+
+protected:
+    // bytes per frame in memory
+    size_t frameSize( ) const
+    {
+        return numPixels( ) * 3;
+    }
+
+    // write little endian values to the file
+    void write16( uint16_t value );
+    void write32( uint32_t value );
+
+    size_t m_maxFrames;
+    ms_t m_now = 0;
+    std::vector< ms_t > m_times;
+    std::vector< uint8_t > m_frames;
+
+    FILE *m_file = nullptr;
+    std::vector< uint32_t > m_index; // time and offset of each frame in the file
+};
+
+} // namespace Pattern
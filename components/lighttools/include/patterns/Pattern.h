@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <span>
+#include <variant>
+#include "PixelMap.h"
+#include "Program.h"
+#include "Random.h"
 #include "Strip.h"
 #include "../export.h"
+#include "../color/Frame.h"
 #include "../color/RGB.h"
 
 
@@ -10,18 +17,46 @@ namespace Pattern
 
 typedef uint32_t ms_t; // duration in milliseconds
 
+// Position within the loop for a frame
+//
+// The phase is the offset as a fraction of the loop, so patterns can scale it
+// to whatever they step through with a multiply and shift instead of dividing
+// by the duration.
+struct Frame
+{
+    ms_t offset = 0;        // time into the loop
+    uint16_t phase = 0;     // offset / duration, Q16 ie 0x10000 is the whole loop
+    uint32_t loop = 0;      // loops completed
+};
+
 // A Pattern animates the LEDs of a Strip.
 //
 // A Pattern has a fixed duration and is repeated.  Callers must first call Init()
-// to setup the Pattern, then periodically call Update() with the current offset.
-// After each loop completes, call Loop with offset reset to the beginning of the
-// period.
+// to setup the Pattern, then periodically call Update() with the current Frame.
+// After each loop completes, call Loop with the Frame reset to the beginning of
+// the period.
+//
+// Patterns render into a span of pixels with RenderInit(), RenderLoop() and
+// Render(), which hold the last frame rendered into them, so a pattern can be
+// drawn into any buffer.  Init(), Loop() and Update() render straight into the
+// Strip's pixels, marking what changed.
 //
 // Each Pattern has three colors it can use in any way, as well as three levels
-// that can control any aspect of the Pattern.
+// that can control any aspect of the Pattern.  Random patterns draw from
+// random( loop ), keyed by their seed and the loop count, so they render the
+// same for the same seed.
+//
+// Patterns don't allocate memory, anything they need per pixel comes from the
+// scratch memory given to them by the caller.
 class LIGHTTOOLS_API Pattern
 {
 public:
+    // the most scratch memory any pattern needs, per pixel
+    static constexpr size_t ScratchPerPixel = 2;
+
+    // loop duration
+    static constexpr ms_t Duration = 40;
+
     Pattern( );
 
     virtual ~Pattern() {}
@@ -29,24 +64,61 @@ public:
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip * )
     {
-        return 40;
+        return Duration;
+    }
+
+    // true if frames only depend on the phase, colors and levels, and are worth caching
+    virtual bool cacheable( ) const
+    {
+        return false;
+    }
+
+    // assume nothing, setup all pixels
+    void Init( Strip *strip, const Frame& frame );
+
+    // restarting after a loop expired, but not first call
+    void Loop( Strip *strip, const Frame& frame );
+
+    // update pixels as needed
+    void Update( Strip *strip, const Frame& frame );
+
+    // the same, at an offset into the loop
+    void Init( Strip *strip, ms_t offset )
+    {
+        Init( strip, frameAt( offset ) );
+    }
+
+    void Loop( Strip *strip, ms_t offset )
+    {
+        Loop( strip, frameAt( offset ) );
+    }
+
+    void Update( Strip *strip, ms_t offset )
+    {
+        Update( strip, frameAt( offset ) );
+    }
+
+    // the frame at an offset into the first loop
+    Frame frameAt( ms_t offset )
+    {
+        return { offset, uint16_t( ( uint64_t )offset * 0x10000 / GetDuration( nullptr ) ), 0 };
     }
 
     // assume nothing, setup all pixels
-    virtual void Init( Strip *strip, ms_t offset )
+    virtual void RenderInit( std::span< Color::rgb32_t > pixels, const Frame& frame )
     {
-        strip->setAllColor( Color::rgb32_t::Black( ) );
-        Loop( strip, offset );
+        fill( pixels, Color::rgb32_t::Black( ) );
+        RenderLoop( pixels, frame );
     }
 
     // restarting after a loop expired, but not first call
-    virtual void Loop( Strip *strip, ms_t offset )
+    virtual void RenderLoop( std::span< Color::rgb32_t > pixels, const Frame& frame )
     {
-        Update( strip, offset );
+        Render( pixels, frame );
     }
 
     // update pixels as needed
-    virtual void Update( Strip *, ms_t ) { }
+    virtual void Render( std::span< Color::rgb32_t >, const Frame& ) { }
 
     // returns color
     Color::rgb32_t color( int index ) const
@@ -72,9 +144,137 @@ public:
         m_level[ index % 3 ] = level;
     }
 
+    // sets the seed for random patterns
+    void setSeed( uint32_t seed )
+    {
+        m_seed = seed;
+    }
+
+    // where each pixel is, for patterns that work across space, nullptr for along the strip
+    void setPixelMap( const PixelMap *map )
+    {
+        m_map = map;
+    }
+
+    // working memory owned by the caller, ScratchPerPixel bytes per pixel, set before Init()
+    void setScratch( std::span< uint8_t > scratch )
+    {
+        m_scratch = scratch;
+    }
+
+    // a copy of the pixels owned by the caller, for strips that don't keep them
+    // in memory, set before Init()
+    void setStripPixels( std::span< Color::rgb32_t > pixels )
+    {
+        m_stripPixels = pixels;
+    }
+
 protected:
+    // random numbers for a loop
+    Random random( uint32_t loop ) const
+    {
+        return Random( m_seed, loop );
+    }
+
+    // each pixel's coordinates, empty if there's no map for these pixels
+    std::span< const PixelMap::Point > points( std::span< const Color::rgb32_t > pixels ) const
+    {
+        if ( m_map && m_map->size( ) == pixels.size( ) )
+        {
+            return m_map->points( );
+        }
+        return {};
+    }
+
+    // set each pixel to fn( index ), called in order, noting the pixels changed
+    template< typename Fn >
+    void generate( std::span< Color::rgb32_t > pixels, Fn fn )
+    {
+        size_t first = pixels.size( ), last = 0;
+        for ( size_t i = 0; i < pixels.size( ); ++i )
+        {
+            Color::rgb32_t color( fn( i ) );
+            if ( color != pixels[ i ] )
+            {
+                pixels[ i ] = color;
+                first = std::min( first, i );
+                last = i;
+            }
+        }
+        if ( first <= last )
+        {
+            changed( first, last + 1 );
+        }
+    }
+
+    // set each pixel to fn( color ), noting the pixels changed
+    template< typename Fn >
+    void transform( std::span< Color::rgb32_t > pixels, Fn fn )
+    {
+        generate( pixels, [ & ]( size_t i )
+        {
+            return fn( pixels[ i ] );
+        } );
+    }
+
+    // set all pixels to a color
+    void fill( std::span< Color::rgb32_t > pixels, Color::rgb32_t color )
+    {
+        generate( pixels, [ = ]( size_t )
+        {
+            return color;
+        } );
+    }
+
+    // fade all pixels towards black by level, 255 is unchanged, noting the pixels changed
+    void fade( std::span< Color::rgb32_t > pixels, uint8_t level )
+    {
+        // only lit pixels change, so fade the span from the first to the last
+        auto lit = []( Color::rgb32_t color )
+        {
+            return color != 0;
+        };
+        auto first = std::find_if( pixels.begin( ), pixels.end( ), lit );
+        if ( first == pixels.end( ) )
+        {
+            return;
+        }
+        auto end = std::find_if( pixels.rbegin( ), pixels.rend( ), lit ).base( );
+        Color::FadeFrame( std::span< Color::rgb32_t >( first, end ), level );
+        changed( first - pixels.begin( ), end - pixels.begin( ) );
+    }
+
+    // set a single pixel to a color
+    void set( std::span< Color::rgb32_t > pixels, size_t pixel, Color::rgb32_t color )
+    {
+        if ( pixels[ pixel ] != color )
+        {
+            pixels[ pixel ] = color;
+            changed( pixel, pixel + 1 );
+        }
+    }
+
+    // note pixels changed by rendering
+    void changed( size_t first, size_t end )
+    {
+        m_changedFirst = std::min( m_changedFirst, first );
+        m_changedEnd = std::max( m_changedEnd, end );
+    }
+
+    // render into the strip, marking the pixels changed, strips that don't keep
+    // their pixels in memory are rendered through setStripPixels()
+    template< typename Fn >
+    void renderStrip( Strip *strip, Fn render );
+
     Color::rgb32_t m_color[ 3 ];
     uint8_t m_level[ 3 ];
+    uint32_t m_seed = 0;
+    const PixelMap *m_map = nullptr;
+    std::span< uint8_t > m_scratch;
+
+private:
+    size_t m_changedFirst = 0, m_changedEnd = 0; // pixels changed by the render in progress
+    std::span< Color::rgb32_t > m_stripPixels; // pixels for strips that don't keep them in memory
 };
 
 
@@ -92,111 +292,145 @@ enum PatternId
     Strobe,
     CandyCane,
     Test,
+    Bytecode, // plays ProgramStore slot 0, Bytecode + 1 plays slot 1 and so on
 };
 
-// Pattern factory
-//--> do this without allocating the Pattern - map IDs to types instead
-LIGHTTOOLS_API Pattern *CreatePattern( uint8_t pattern );
+// Pattern name, for logs and tools
+LIGHTTOOLS_API const char *PatternName( uint8_t pattern );
 
 
 // Flash the entire strip
 class LIGHTTOOLS_API FlashPattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 4000;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 // Rainbow!
+//
+// With a pixel map it runs across the layout, level 2 picks the axis: 0 - 63 x,
+// 64 - 127 y, 128 - 191 angle, 192 - 255 radius
 class LIGHTTOOLS_API RainbowPattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 2000;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
+    // frames only depend on the phase, colors and levels, and cost more than copying
+    virtual bool cacheable( ) const
+    {
+        return true;
+    }
+
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 class LIGHTTOOLS_API SparklePattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 100;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Loop( Strip *strip, ms_t offset );
+    virtual void RenderLoop( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 class LIGHTTOOLS_API MiniSparklePattern : public SparklePattern
 {
 public:
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 class LIGHTTOOLS_API MiniTwinklePattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 1000;
+
     MiniTwinklePattern();
 
     // assume nothing, setup all pixels
-    virtual void Init( Strip *strip, ms_t offset );
+    virtual void RenderInit( std::span< Color::rgb32_t > pixels, const Frame& frame );
 
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 
 protected:
-    ms_t delta( ms_t previous, ms_t next, ms_t duration );
-
-    ms_t m_lastDim;
-    ms_t m_lastLit;
+    uint16_t m_lastDim; // phase
+    uint32_t m_litLoop; // loop the pixels are being lit for
+    long m_lit; // pixels lit so far in that loop
 };
 
 class LIGHTTOOLS_API MarchPattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 1000;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
+    // frames only depend on the phase, colors and levels, and cost more than copying
+    virtual bool cacheable( ) const
+    {
+        return true;
+    }
+
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
+// Colors wiping along the strip, or across the layout with a pixel map, level 2
+// picking the axis as for RainbowPattern
 class LIGHTTOOLS_API WipePattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 3000;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
+    // frames only depend on the phase, colors and levels, and cost more than copying
+    virtual bool cacheable( ) const
+    {
+        return true;
+    }
+
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 class LIGHTTOOLS_API GradientPattern : public Pattern
 {
 public:
-    GradientPattern( );
+    static constexpr ms_t Duration = 1000;
 
-    ~GradientPattern( );
+    GradientPattern( );
 
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // assume nothing, setup all pixels
-    virtual void Init( Strip *strip, ms_t offset );
+    virtual void RenderInit( std::span< Color::rgb32_t > pixels, const Frame& frame );
 
     // restarting after a loop expired, but not first call
-    virtual void Loop( Strip *strip, ms_t offset );
+    virtual void RenderLoop( std::span< Color::rgb32_t > pixels, const Frame& frame );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 
     virtual void setColor( int index, Color::rgb32_t color );
 
@@ -205,8 +439,14 @@ public:
 private:
     void ResetGradient();
 
-    Color::Gradient grad;
-    uint8_t *mp1, *mp2;
+    // palette position of a pixel index
+    static uint8_t position( size_t index, size_t count )
+    {
+        return index * 255 / count;
+    }
+
+    Color::Gradient m_gradient; // of the colors and level
+    uint8_t *mp1, *mp2; // palette positions for each pixel, in the scratch memory
     bool changed = false; // true if color/level changed and need to reset gradient
 };
 
@@ -214,33 +454,39 @@ private:
 class LIGHTTOOLS_API StrobePattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 750; // 4Hz at 100% speed, 10Hz at 250% speed
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 
-    ms_t m_lastOffset;
+    uint16_t m_lastPhase = 0;
 };
 
 class LIGHTTOOLS_API FixedPattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 750;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 class LIGHTTOOLS_API CandyCanePattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 200;
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
 };
 
 // test patterns
@@ -251,11 +497,47 @@ public:
 class LIGHTTOOLS_API TestPattern : public Pattern
 {
 public:
+    static constexpr ms_t Duration = 1000;
+
+    // returns loop duration, time offset never goes above this
+    virtual ms_t GetDuration( Strip *strip );
+
+    // update pixels as needed
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
+
+private:
+    Color::Gradient m_gradient; // for the gradient test
+};
+
+// Plays a program from a ProgramStore slot
+//
+// The program is looked up each frame, so a new program in the slot takes over
+// straight away, though the loop duration is the one when the pattern started.
+class LIGHTTOOLS_API ProgramPattern : public Pattern
+{
+public:
+    ProgramPattern( int slot = 0 )
+        : m_slot( slot )
+    {
+    }
+
     // returns loop duration, time offset never goes above this
     virtual ms_t GetDuration( Strip *strip );
 
     // update pixels as needed
-    virtual void Update( Strip *strip, ms_t offset );
+    virtual void Render( std::span< Color::rgb32_t > pixels, const Frame& frame );
+
+protected:
+    int m_slot;
 };
 
+
+// In place storage for any one Pattern
+typedef std::variant< std::monostate, MiniTwinklePattern, MiniSparklePattern, SparklePattern, RainbowPattern,
+    FlashPattern, MarchPattern, WipePattern, GradientPattern, FixedPattern, StrobePattern, CandyCanePattern,
+    TestPattern, ProgramPattern > PatternStorage;
+
+// Pattern factory, creates the pattern in storage replacing whatever was there
+LIGHTTOOLS_API Pattern *CreatePattern( uint8_t pattern, PatternStorage& storage );
+
 } // namespace Pattern
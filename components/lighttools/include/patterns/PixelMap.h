@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "../export.h"
+
+
+namespace Pattern
+{
+
+// Where each pixel of a strip is, for patterns that work across space rather
+// than along the strip
+//
+// Positions are worked out once, when the map is made, and kept as 8 bit
+// coordinates, so the table is 4 bytes a pixel: x and y across the layout's
+// bounding box, and the angle and distance from its center for round layouts.
+// Patterns read the coordinate they need from the table instead of working it
+// out from the pixel index.
+//
+// The map is in the order patterns render in.  How that order is wired, for
+// example a serpentine matrix, is up to the output, see Serpentine().
+class LIGHTTOOLS_API PixelMap
+{
+public:
+    enum Axis : uint8_t
+    {
+        X,
+        Y,
+        Angle,      // 0 - 255 is once around, counterclockwise from +x
+        Radius,     // 255 is the pixel furthest from the center
+    };
+
+    // a pixel's coordinate on each axis
+    typedef std::array< uint8_t, 4 > Point;
+
+    // pixels in a line, along x
+    static PixelMap Line( uint16_t count );
+
+    // a matrix of rows, row by row from the top left
+    static PixelMap Matrix( uint16_t width, uint16_t height );
+
+    // pixels evenly spaced around a circle, counterclockwise from +x
+    static PixelMap Ring( uint16_t count );
+
+    // pixels at arbitrary x, y positions, for irregular layouts
+    static PixelMap Positions( std::span< const std::array< uint8_t, 2 > > positions );
+
+    // wire order for a serpentine matrix, rows alternating direction, the nth
+    // pixel on the wire shows the nth index of the result
+    static std::vector< uint16_t > Serpentine( uint16_t width, uint16_t height );
+
+    // number of pixels
+    size_t size( ) const
+    {
+        return m_points.size( );
+    }
+
+    // each pixel's coordinates
+    std::span< const Point > points( ) const
+    {
+        return m_points;
+    }
+
+private:
+    // works out the angle and radius from x and y
+    void polar( );
+
+    std::vector< Point > m_points;
+};
+
+} // namespace Pattern
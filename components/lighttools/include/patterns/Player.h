@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <vector>
 #include "../export.h"
 #include "Pattern.h"
 
@@ -15,34 +17,108 @@ struct PlayerControl
     uint8_t speed;
     Color::rgb24_t color[ 3 ];
     uint8_t level[ 3 ] = { 0x80, 0x80, 0x80 };
+    uint8_t transition = 0; // crossfade from the previous pattern, in 10ms steps, 0 to cut
+    uint32_t seed = 0; // for random patterns, nodes with the same seed render the same
 };
 #pragma pack( pop )
 
 
 // Manages the playback state of a Pattern, including looping and dynamic speed adjustments
+//
+// The position in the pattern is a fixed point count of loops, advanced by the
+// time since the last update at the current speed.  Each frame the pattern gets
+// the loop count and Q16 phase straight from it, and speed changes carry on
+// from wherever the pattern is.
+//
+// When the pattern changes with a transition time, the outgoing pattern keeps
+// playing and the two are crossfaded, each rendering into its own buffer.
+//
+// Patterns that only depend on the phase can be played from a loop cache, a frame for each
+// step of the phase, rendered the first time the step comes up and copied out
+// after that.  The cache is kept until the pattern, colors, levels or strip
+// size change.
+//
+// The Patterns are held in place and their scratch memory and buffers are kept
+// between patterns, so once the first transition for a strip is set up,
+// switching patterns doesn't touch the heap.
 class LIGHTTOOLS_API Player
 {
 public:
     Player()
-        : m_start( 0 ), m_pattern( 0 ), m_patternId( -1 ),
-          m_offset( 0 ), m_count( 0 ), m_speed( 35 )
+        : m_patternId( -1 ), m_speed( 35 )
     {
     }
 
+    // patterns point into m_storage
+    Player( const Player& ) = delete;
+    Player& operator=( const Player& ) = delete;
+
     //! update to the player with a new pattern, and/or changed pattern parameters
     void UpdatePattern( ms_t now, const PlayerControl& control, Strip *strip );
 
     //! update the strip with the current pattern
     void UpdateStrip( ms_t now, Strip *strip );
 
+    //! cache patterns that only depend on the phase in frames of resolution ms of the loop, at 100% speed,
+    //! if the loop fits in maxBytes, 0 to turn it off
+    void setLoopCache( ms_t resolution, size_t maxBytes );
+
+    //! true while crossfading between patterns
+    bool transitioning( ) const
+    {
+        return m_outgoing.pattern;
+    }
+
 protected:
-    ms_t m_start; // time we started the current pattern, adjusted when changing speed
+    // a pattern and where it is in its loop
+    struct Track
+    {
+        Pattern *pattern = nullptr;
+        ms_t duration = 1;
+        uint64_t position = 0; // loops in the top 32 bits, then the Q16 phase and 16 more bits of fraction
+        uint64_t step = 0; // position per ms at the current speed
+        uint32_t loop = 0; // the loop count when Loop() was last called
+
+        // the frame at the current position, and true if a loop completed
+        Frame frame( bool& looped );
+    };
 
-    Pattern *m_pattern;
+    // start a crossfade from the current pattern
+    void startTransition( ms_t now, ms_t duration, Strip *strip );
+
+    // render a frame of the crossfade
+    void updateTransition( ms_t now, Strip *strip );
+
+    // set up the loop cache for the current pattern, or turn it off if it can't be cached
+    void resetCache( Strip *strip );
+
+    // render the current frame from the loop cache
+    void updateCached( Strip *strip );
+
+    // move the position on to now at the current speed
+    void advance( ms_t now );
+
+    std::array< PatternStorage, 2 > m_storage; // the current pattern, and the outgoing one
+    size_t m_slot = 0; // storage and scratch used by the current pattern
+    Track m_current;
+    Track m_outgoing; // the pattern fading out, if any
     uint8_t m_patternId;
-    ms_t m_offset; // the last offset we were at, needed when speed is 0
-    unsigned long m_count; // the cycle count when Loop() was last called, scaled by speed
     uint8_t m_speed; // speed as a percent, ie 0 - 255%
+    ms_t m_last = 0; // time the positions were last advanced
+    std::vector< uint8_t > m_scratch; // pattern working memory, grows to fit the strip
+    std::vector< Color::rgb32_t > m_stripPixels; // the pixels of strips that don't keep them in memory
+
+    ms_t m_transitionStart = 0, m_transitionTime = 0;
+    std::vector< Color::rgb32_t > m_outgoingPixels, m_currentPixels; // each pattern's frame while crossfading
+    std::vector< Color::rgb32_t > m_framePixels; // the crossfaded frame
+
+    ms_t m_cacheResolution = 0;
+    size_t m_cacheBytes = 0;
+    uint32_t m_cacheFrames = 0; // frames in the loop cache, 0 when not caching
+    size_t m_cachePixels = 0; // pixels in each frame
+    std::vector< Color::rgb32_t > m_cache; // the frames, one after the other
+    std::vector< bool > m_cached; // frames rendered so far
+    PlayerControl m_cacheControl; // the colors and levels the frames were rendered with
 };
 
 } // namespace Pattern
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "../export.h"
+
+
+namespace Pattern
+{
+
+// Keeps the estimated LED current of each frame under a budget
+//
+// The encoder sums the output levels of a frame as it converts it, and the
+// limiter turns that into an estimated current and the scale the frame can be
+// sent at.  When a frame would go over the budget the scale drops straight
+// away, so no frame is sent over it, then recovers over several frames once
+// the frames get dimmer again, so the output doesn't pump.
+//
+// The scale for a frame is only known once it has been encoded, so frames are
+// encoded at the scale of the previous one and rescaled when that's too high.
+class LIGHTTOOLS_API PowerLimiter
+{
+public:
+    // scale for full output
+    static constexpr uint16_t Unity = 256;
+
+    // current budget in mA, 0 for no limit
+    uint32_t budget( ) const
+    {
+        return m_budget;
+    }
+
+    // current budget in mA, 0 for no limit
+    void setBudget( uint32_t milliamps );
+
+    // current of one channel at full output, and of each pixel when dark, in uA
+    void setModel( uint32_t channelMicroamps, uint32_t idleMicroamps );
+
+    // output scale for the next frame, Unity for full output
+    uint16_t scale( ) const
+    {
+        return m_scale;
+    }
+
+    // true while the scale is still recovering, ie the output will change
+    // even if the frame doesn't
+    bool recovering( ) const
+    {
+        return m_scale < m_allowed;
+    }
+
+    // estimated current of the last frame, as sent, in mA
+    uint32_t current( ) const
+    {
+        return m_current;
+    }
+
+    // estimated current in mA of pixels whose output levels add up to levels
+    uint32_t estimate( uint32_t levels, size_t pixels ) const;
+
+    // takes the sum of the unscaled output levels of a frame, and returns the
+    // scale it must be sent at
+    uint16_t update( uint32_t levels, size_t pixels );
+
+private:
+    // how quickly the scale recovers, 1 / 2^n of the way each frame
+    static constexpr int RecoveryShift = 3;
+
+    uint32_t m_budget = 0;
+    uint32_t m_channel = 20000; // WS2812, 20mA per channel
+    uint32_t m_idle = 1000;     // and about 1mA quiescent
+    uint16_t m_scale = Unity;
+    uint16_t m_allowed = Unity;
+    uint32_t m_current = 0;
+};
+
+} // namespace Pattern
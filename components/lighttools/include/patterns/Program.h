@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include "../export.h"
+
+
+namespace Pattern
+{
+
+// Pattern bytecode
+//
+// A program runs once per pixel, each instruction working on 16 32 bit
+// registers.  Before each pixel the inputs are loaded:
+//   r0 pixel index, r1 pixel count, r2 phase (0 - 65535), r3 loop count,
+//   r4 - r6 levels, r7 the pixel's color from the last frame, packed 0x00rrggbb
+// r7 is the pixel's new color when the program ends.  r8 - r15 start each frame
+// at 0 and carry over from one pixel to the next.  Colors are packed as r7 is,
+// levels and channels are 0 - 255.
+//
+// Jumps only go forward, so every program runs in a bounded time.
+enum class Op : uint8_t
+{
+    End,        // stop, the pixel is r7
+    Load,       // d = int16( a | b << 8 )
+    Move,       // d = a
+    Add,        // d = a + b
+    AddImm,     // d = a + int8( b ), b is a value rather than a register
+    Sub,        // d = a - b
+    Mul,        // d = a * b
+    Scale,      // d = a * b >> 8
+    Div,        // d = a / b, 0 if b is 0
+    Mod,        // d = a % b, 0 if b is 0
+    And,        // d = a & b
+    Or,         // d = a | b
+    Xor,        // d = a ^ b
+    Shl,        // d = a << b
+    Shr,        // d = a >> b, arithmetic
+    Min,        // d = min( a, b )
+    Max,        // d = max( a, b )
+    Less,       // d = a < b ? 1 : 0
+    Equal,      // d = a == b ? 1 : 0
+    Triangle,   // d = triangle wave of a & 255, 0 - 255 - 0
+    Random,     // d = random 0 - 65535 keyed by a, the seed and the loop
+    Color,      // d = color[ a % 3 ]
+    Wheel,      // d = color wheel at a & 255
+    Fade,       // d = color a faded to level b
+    Blend,      // d = color a blended to color b by level d
+    Pack,       // d = color from r, g, b in d, d + 1, d + 2, clamped to 0 - 255
+    Unpack,     // d, d + 1, d + 2 = r, g, b of color a
+    Jump,       // go to instruction b
+    JumpZero,   // go to instruction b if a is 0
+    JumpNotZero,// go to instruction b if a isn't 0
+    Count
+};
+
+#pragma pack( push, 1 )
+// One instruction, d is the destination register and a and b are source registers
+struct Instruction
+{
+    Op op;
+    uint8_t d, a, b;
+};
+#pragma pack( pop )
+
+// A validated pattern program
+//
+// Program bytes, as sent between nodes, are a header of "RP", a version byte,
+// the instruction count and the loop duration in ms as uint16 little endian,
+// then the instructions 4 bytes each.
+class LIGHTTOOLS_API Program
+{
+public:
+    static constexpr uint8_t Version = 1;
+    static constexpr size_t HeaderSize = 6;
+    static constexpr size_t MaxInstructions = 64;
+    static constexpr size_t MaxSize = HeaderSize + MaxInstructions * sizeof( Instruction );
+    static constexpr int Registers = 16;
+
+    // load program bytes, returns false and keeps the program as it was if they're invalid
+    bool load( std::span< const uint8_t > bytes );
+
+    // program bytes for code, returns the size or 0 if it doesn't fit
+    static size_t encode( uint16_t duration, std::span< const Instruction > code, std::span< uint8_t > bytes );
+
+    // true if there's no program
+    bool empty( ) const
+    {
+        return !m_count;
+    }
+
+    // loop duration in ms
+    uint16_t duration( ) const
+    {
+        return m_duration;
+    }
+
+    std::span< const Instruction > code( ) const
+    {
+        return std::span< const Instruction >( m_code.data( ), m_count );
+    }
+
+private:
+    std::array< Instruction, MaxInstructions > m_code;
+    uint8_t m_count = 0;
+    uint16_t m_duration = 1000;
+};
+
+#pragma pack( push, 1 )
+// Part of a program being sent to a ProgramStore slot
+struct ProgramChunk
+{
+    static constexpr size_t DataSize = 192; // fits an ESP-NOW frame, a program is 2 chunks at most
+
+    uint8_t slot;
+    uint8_t id;         // changes with each program sent to the slot
+    uint8_t index;      // this chunk
+    uint8_t count;      // chunks in the program
+    uint8_t length;     // bytes used in data
+    uint8_t data[ DataSize ];
+};
+#pragma pack( pop )
+
+// Programs for ProgramPatterns to run, loaded from chunks as they come in
+class LIGHTTOOLS_API ProgramStore
+{
+public:
+    static constexpr int Slots = 4;
+    static constexpr size_t MaxChunks = ( Program::MaxSize + ProgramChunk::DataSize - 1 ) / ProgramChunk::DataSize;
+
+    // split program bytes into chunks, returns the number of chunks or 0 if it's too big
+    static size_t split( std::span< const uint8_t > bytes, uint8_t slot, uint8_t id, std::span< ProgramChunk > chunks );
+
+    // add a chunk, returns true when it completes a valid program, which replaces the slot's program
+    // chunks have to come in order, one out of sequence drops the program being received
+    bool receive( const ProgramChunk& chunk );
+
+    const Program& program( int slot ) const
+    {
+        return m_programs[ slot % Slots ];
+    }
+
+    Program& program( int slot )
+    {
+        return m_programs[ slot % Slots ];
+    }
+
+private:
+    // a program being received
+    struct Transfer
+    {
+        uint8_t id = 0;
+        uint8_t count = 0; // 0 when nothing is being received
+        uint8_t received = 0; // chunks so far
+        std::array< uint8_t, MaxChunks * ProgramChunk::DataSize > bytes;
+    };
+
+    std::array< Program, Slots > m_programs;
+    std::array< Transfer, Slots > m_transfers;
+};
+
+// The programs played by ProgramPatterns
+LIGHTTOOLS_API ProgramStore& Programs( );
+
+// Example programs, for tools and for loading as defaults
+struct ExampleProgram
+{
+    const char *name;
+    uint16_t duration;
+    std::span< const Instruction > code;
+};
+LIGHTTOOLS_API std::span< const ExampleProgram > ExamplePrograms( );
+
+} // namespace Pattern
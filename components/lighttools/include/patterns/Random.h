@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace Pattern
+{
+
+// Counter based random numbers
+//
+// Each number is a hash of a key and its index, rather than the next state of a
+// shared generator, so any number in a sequence can be computed directly.  A
+// pattern keyed by its seed and loop count draws the same numbers for a loop on
+// every node, wherever it joins, and without any locking.
+class Random
+{
+public:
+    constexpr Random( uint32_t seed = 0, uint32_t loop = 0 )
+        : m_key( hash( seed ^ hash( loop + Weyl ) ) )
+    {
+    }
+
+    // the number at index in the sequence
+    constexpr uint32_t operator()( uint32_t index ) const
+    {
+        return hash( m_key + index * Weyl );
+    }
+
+    // the number at index, scaled to 0 - ( range - 1 ) without a divide
+    constexpr uint32_t below( uint32_t index, uint32_t range ) const
+    {
+        return ( ( uint64_t )( *this )( index ) * range ) >> 32;
+    }
+
+    // 32 bit integer hash, from "lowbias32" by Chris Wellons
+    static constexpr uint32_t hash( uint32_t x )
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352d;
+        x ^= x >> 15;
+        x *= 0x846ca68b;
+        x ^= x >> 16;
+        return x;
+    }
+
+private:
+    static constexpr uint32_t Weyl = 0x9e3779b9; // golden ratio, spreads out neighbouring counters
+
+    uint32_t m_key;
+};
+
+} // namespace Pattern
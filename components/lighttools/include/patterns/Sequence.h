@@ -4,6 +4,7 @@
 #include <span>
 #include "../export.h"
 #include "Player.h"
+#include "Random.h"
 
 
 namespace Pattern
@@ -66,8 +67,14 @@ protected:
 class LIGHTTOOLS_API RandomSequence : public OrderedSequence
 {
 public:
+    RandomSequence( uint32_t seed = 0 ) : m_random( seed ) {}
+
     virtual int Reset( );
     virtual int Advance( int step, bool timed = false );
+
+protected:
+    Random m_random;
+    uint32_t m_draws = 0; // steps picked so far
 };
 
 // Predefined steps
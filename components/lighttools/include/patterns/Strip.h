@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <span>
 #include "../export.h"
 #include "../color/RGB.h"
 
@@ -7,6 +9,8 @@
 namespace Pattern
 {
 
+class PixelMap;
+
 // Pixel strip abstract base class
 class LIGHTTOOLS_API Strip
 {
@@ -25,14 +29,233 @@ public:
     // set all pixels to a color
     virtual void setAllColor( Color::rgb32_t color );
 
+    // direct access to the pixels, empty if the strip doesn't keep them in memory
+    // call markDirty() for any pixels changed this way
+    virtual std::span< Color::rgb32_t > pixels( )
+    {
+        return {};
+    }
+
+    // set count pixels starting at first to a color
+    virtual void fillRange( uint16_t first, uint16_t count, Color::rgb32_t color );
+
+    // copy count pixels starting at src to dst, the ranges may overlap
+    virtual void copyRange( uint16_t dst, uint16_t src, uint16_t count );
+
+    // set pixels starting at first to colors
+    virtual void writePixels( std::span< const Color::rgb32_t > colors, uint16_t first = 0 );
+
+    // set each pixel to fn( index ), in place if the strip allows it
+    template< typename Fn >
+    void generatePixels( Fn fn )
+    {
+        auto px( pixels( ) );
+        if ( !px.empty( ) )
+        {
+            size_t first = px.size( ), last = 0;
+            for ( size_t i = 0; i < px.size( ); ++i )
+            {
+                Color::rgb32_t color( fn( i ) );
+                if ( color != px[ i ] )
+                {
+                    px[ i ] = color;
+                    first = std::min( first, i );
+                    last = i;
+                }
+            }
+            if ( first <= last )
+            {
+                markDirty( first, last + 1 - first );
+            }
+        }
+        else
+        {
+            for ( uint16_t i = 0, count = numPixels( ); i < count; ++i )
+            {
+                setPixelColor( i, fn( i ) );
+            }
+        }
+    }
+
+    // set each pixel to fn( color ), in place if the strip allows it
+    template< typename Fn >
+    void transformPixels( Fn fn )
+    {
+        auto px( pixels( ) );
+        if ( !px.empty( ) )
+        {
+            size_t first = px.size( ), last = 0;
+            for ( size_t i = 0; i < px.size( ); ++i )
+            {
+                Color::rgb32_t color( fn( px[ i ] ) );
+                if ( color != px[ i ] )
+                {
+                    px[ i ] = color;
+                    first = std::min( first, i );
+                    last = i;
+                }
+            }
+            if ( first <= last )
+            {
+                markDirty( first, last + 1 - first );
+            }
+        }
+        else
+        {
+            for ( uint16_t i = 0, count = numPixels( ); i < count; ++i )
+            {
+                setPixelColor( i, fn( getPixelColor( i ) ) );
+            }
+        }
+    }
+
+    // where each pixel is, nullptr if only the order along the strip is known
+    const PixelMap *pixelMap( ) const
+    {
+        return m_pixelMap;
+    }
+
+    // where each pixel is, the map must last as long as the strip uses it
+    void setPixelMap( const PixelMap *map )
+    {
+        m_pixelMap = map;
+    }
+
     // independent control of brightness
     virtual uint8_t getBrightness( ) const = 0;
 
     // independent control of brightness
     virtual void setBrightness( uint8_t bright ) = 0;
 
+    // record pixels as changed since the last transmit
+    void markDirty( uint16_t first, uint16_t count )
+    {
+        m_dirtyFirst = std::min( m_dirtyFirst, first );
+        m_dirtyEnd = std::max< uint32_t >( m_dirtyEnd, first + count );
+    }
+
+    // record all pixels as changed since the last transmit
+    void markDirty( )
+    {
+        markDirty( 0, numPixels( ) );
+    }
+
+    // returns true if anything changed since the last transmit
+    bool isDirty( ) const
+    {
+        return m_dirtyFirst < m_dirtyEnd;
+    }
+
+    // first pixel changed since the last transmit
+    uint16_t dirtyFirst( ) const
+    {
+        return m_dirtyFirst;
+    }
+
+    // one past the last pixel changed since the last transmit
+    uint16_t dirtyEnd( ) const
+    {
+        return std::min< uint32_t >( m_dirtyEnd, numPixels( ) );
+    }
+
+    // don't send frames that haven't changed, but resend after maxSkipped
+    // consecutive skips (0 for never) in case the LEDs picked up a glitch
+    void setSkipUnchanged( bool skip, uint16_t maxSkipped = 0 )
+    {
+        m_skipUnchanged = skip;
+        m_maxSkipped = maxSkipped;
+    }
+
+    // number of frames sent to the hardware
+    uint32_t framesSent( ) const
+    {
+        return m_framesSent;
+    }
+
+    // number of unchanged frames that weren't sent
+    uint32_t framesSkipped( ) const
+    {
+        return m_framesSkipped;
+    }
+
     // send the buffered pixel data to the hardware
-    virtual void transmit() const = 0;
+    virtual void transmit() = 0;
+
+    // start sending the buffered pixel data to the hardware without waiting for
+    // it to complete, pixels may be changed as soon as this returns
+    virtual void transmitAsync( )
+    {
+        transmit( );
+    }
+
+    // wait for the transmission in progress to complete
+    // returns false if it's still in progress after timeout (in ms)
+    virtual bool waitTransmit( [[maybe_unused]] uint32_t timeout )
+    {
+        return true;
+    }
+
+    // estimated time to send a frame to the hardware, in us
+    virtual uint32_t transmitTime( ) const
+    {
+        // 24 bits per pixel at 800kHz, then the reset code
+        return numPixels( ) * 30 + 50;
+    }
+
+    // called each time a frame has been completely sent, note that on hardware
+    // this may be from an interrupt
+    typedef void ( *TransmitDone )( void *arg );
+
+    // set the callback for completed frames, or nullptr for none
+    virtual void setTransmitDone( TransmitDone callback, void *arg )
+    {
+        m_transmitDone = callback;
+        m_transmitDoneArg = arg;
+    }
+
+protected:
+    // counts the frame as sent or skipped, returns false if it should be skipped
+    bool startFrame( )
+    {
+        if ( m_skipUnchanged && !isDirty( ) && ( !m_maxSkipped || m_skipCount < m_maxSkipped ) )
+        {
+            ++m_skipCount;
+            ++m_framesSkipped;
+            return false;
+        }
+        m_skipCount = 0;
+        ++m_framesSent;
+        return true;
+    }
+
+    // forget changes once they're sent
+    void clearDirty( )
+    {
+        m_dirtyFirst = UINT16_MAX;
+        m_dirtyEnd = 0;
+    }
+
+    // call the completed frame callback, if any
+    void transmitDone( ) const
+    {
+        if ( m_transmitDone )
+        {
+            m_transmitDone( m_transmitDoneArg );
+        }
+    }
+
+    const PixelMap *m_pixelMap = nullptr;
+
+    TransmitDone m_transmitDone = nullptr;
+    void *m_transmitDoneArg = nullptr;
+
+    uint16_t m_dirtyFirst = 0; // changed pixel range, everything until the first transmit
+    uint32_t m_dirtyEnd = UINT16_MAX;
+    bool m_skipUnchanged = false;
+    uint16_t m_maxSkipped = 0;
+    uint16_t m_skipCount = 0; // consecutive frames skipped
+    uint32_t m_framesSent = 0;
+    uint32_t m_framesSkipped = 0;
 };
 
 }
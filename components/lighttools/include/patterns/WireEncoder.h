@@ -0,0 +1,189 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "../export.h"
+#include "../color/RGB.h"
+#include "PowerLimiter.h"
+
+
+namespace Pattern
+{
+
+// Byte order of a pixel on the wire
+enum class WireFormat : uint8_t
+{
+    GRB,    // WS2812 and friends
+    GRBW,   // SK6812 RGBW, white is extracted from the RGB
+};
+
+// Converts a frame of rgb32_t pixels into the byte stream shifted out to the LEDs.
+//
+// The output is in wire order with the output correction already applied, so
+// it can be handed straight to the transmitter.  Global brightness, a gamma curve
+// and per channel white balance gains are folded into a lookup table for each
+// channel that is only rebuilt when one of them changes, the encode pass is then
+// one table load per channel.
+//
+// Optionally the tables hold 16 bit linear values (8.8 fixed point) instead,
+// and the encode pass dithers them down to 8 bits over time: the fraction lost
+// on each channel is carried into the next frame, so a level between two 8 bit
+// steps averages out at the refresh rate.  This keeps fades smooth at low
+// brightness, where the corrected output only has a few steps.
+//
+// For RGBW strips the white is extracted from each pixel (see
+// Color::WhiteExtractor) in the same pass, before the correction tables.
+//
+// With a wire order set, eg for a serpentine matrix, pixels are gathered into
+// that order first, so patterns can render in their own order.
+//
+// With a power budget set the same pass also sums the output levels, and the
+// frame is scaled to keep its estimated current in budget (see PowerLimiter).
+class LIGHTTOOLS_API WireEncoder
+{
+public:
+    // most bytes per pixel on the wire
+    static constexpr size_t MaxPixelSize = 4;
+
+    WireEncoder( WireFormat format = WireFormat::GRB );
+
+    // wire byte order
+    WireFormat format( ) const
+    {
+        return m_format;
+    }
+
+    // bytes per pixel on the wire
+    size_t pixelSize( ) const
+    {
+        return ( m_format == WireFormat::GRBW ) ? 4 : 3;
+    }
+
+    // returns the number of wire bytes needed for a number of pixels
+    size_t size( size_t pixels ) const
+    {
+        return pixels * pixelSize( );
+    }
+
+    // brightness applied to each channel
+    uint8_t brightness( ) const
+    {
+        return m_brightness;
+    }
+
+    // brightness applied to each channel
+    void setBrightness( uint8_t bright );
+
+    // gamma curve applied to each channel, 1.0 is linear
+    float gamma( ) const
+    {
+        return m_gamma;
+    }
+
+    // gamma curve applied to each channel, 1.0 is linear
+    void setGamma( float gamma );
+
+    // white balance gain for each channel, 255 is unity
+    Color::rgb32_t whiteBalance( ) const
+    {
+        return m_whiteBalance;
+    }
+
+    // white balance gain for each channel, 255 is unity
+    void setWhiteBalance( Color::rgb32_t gains );
+
+    // splits pixels into RGBW, for GRBW format
+    const Color::WhiteExtractor& whiteExtractor( ) const
+    {
+        return m_white;
+    }
+
+    // splits pixels into RGBW, for GRBW format
+    void setWhiteExtractor( const Color::WhiteExtractor& white )
+    {
+        m_white = white;
+    }
+
+    // current limiting of the encoded frames
+    PowerLimiter& limiter( )
+    {
+        return m_limiter;
+    }
+
+    // current limiting of the encoded frames
+    const PowerLimiter& limiter( ) const
+    {
+        return m_limiter;
+    }
+
+    // true if the pixels are reordered on the wire
+    bool ordered( ) const
+    {
+        return !m_order.empty( );
+    }
+
+    // the nth pixel on the wire is pixels[ order[ n ] ], for frames the same
+    // size as order, empty to send pixels as they are
+    void setOrder( std::span< const uint16_t > order )
+    {
+        m_order.assign( order.begin( ), order.end( ) );
+    }
+
+    // true if encodeDithered() is to be used
+    bool dither( ) const
+    {
+        return m_dither;
+    }
+
+    // enable the 16 bit tables for encodeDithered()
+    void setDither( bool dither );
+
+    // encode pixels in wire order, out must hold size( pixels.size( ) ) bytes
+    // with a power budget or wire order set pixels must be the whole frame
+    void encode( std::span< const Color::rgb32_t > pixels, uint8_t *out );
+
+    // encode pixels in wire order with temporal dithering, residual holds the
+    // fraction carried over from the previous frame for each byte in out, and
+    // must be kept between frames, both must hold size( pixels.size( ) ) bytes
+    void encodeDithered( std::span< const Color::rgb32_t > pixels, uint8_t *residual, uint8_t *out );
+
+    // straightforward per pixel version of encode(), to validate faster encoders
+    // against, without power limiting
+    void encodeReference( std::span< const Color::rgb32_t > pixels, uint8_t *out ) const;
+
+private:
+    // encode with or without dithering, applying the power limit
+    template< bool Dither >
+    void encodeFrame( std::span< const Color::rgb32_t > pixels, uint8_t *residual, uint8_t *out );
+
+    // encode in the given format, returns the sum of the unscaled output levels
+    // when limiting, in 8.8 fixed point if dithering
+    template< WireFormat Format, bool Dither, bool Limit >
+    uint32_t encodePixels( std::span< const Color::rgb32_t > pixels, uint8_t *residual, uint8_t *out,
+        uint16_t scale ) const;
+
+    // the corrected output for one channel value
+    uint8_t correct( uint8_t value, uint8_t gain ) const;
+
+    // the corrected output for one channel value, in 8.8 fixed point
+    uint16_t correct16( uint8_t value, uint8_t gain ) const;
+
+    // recalculates the lookup tables
+    void rebuild( );
+
+    uint8_t m_brightness;
+    float m_gamma;
+    Color::rgb32_t m_whiteBalance;
+    bool m_dither;
+    WireFormat m_format;
+    Color::WhiteExtractor m_white;
+    PowerLimiter m_limiter;
+    std::array< std::array< uint8_t, 256 >, MaxPixelSize > m_lut; // corrected values, in wire order
+    std::array< std::array< uint16_t, 256 >, MaxPixelSize > m_lut16; // corrected values in 8.8, when dithering
+    std::vector< uint16_t > m_order; // pixel index for each wire pixel, empty if not reordered
+    std::vector< Color::rgb32_t > m_ordered; // pixels gathered into wire order
+};
+
+} // namespace Pattern
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include "color/Frame.h"
+
+
+namespace Color
+{
+
+namespace
+{
+
+// the channels in the even and odd bytes, each in the low half of a 16 bit lane
+constexpr uint32_t LaneMask = 0x00ff00ff;
+// the bit above each lane's channel
+constexpr uint32_t LaneCarry = 0x01000100;
+
+inline uint32_t even( uint32_t packed )
+{
+    return packed & LaneMask;
+}
+
+inline uint32_t odd( uint32_t packed )
+{
+    return ( packed >> 8 ) & LaneMask;
+}
+
+// lanes * alpha / 256
+inline uint32_t scaleLanes( uint32_t lanes, uint32_t alpha )
+{
+    return ( ( lanes * alpha ) >> 8 ) & LaneMask;
+}
+
+// src * alpha + dst * ( 256 - alpha ), all over 256
+inline uint32_t overLanes( uint32_t dst, uint32_t src, uint32_t alpha )
+{
+    return ( ( src * alpha + dst * ( 256 - alpha ) ) >> 8 ) & LaneMask;
+}
+
+// lanes / 255, rounded down, for lanes up to 255 * 255
+inline uint32_t div255Lanes( uint32_t lanes )
+{
+    return ( ( lanes + ( ( lanes >> 8 ) & LaneMask ) + ( LaneCarry >> 8 ) ) >> 8 ) & LaneMask;
+}
+
+// from + ( to - from ) * level / 255, rounded towards from, as Color::fade()
+inline uint32_t blendLanes( uint32_t from, uint32_t to, uint32_t level )
+{
+    // the guard bit survives the subtract only where to >= from, rising is 0xff there
+    uint32_t up = ( to | LaneCarry ) - from;
+    uint32_t rising = up & LaneCarry;
+    rising -= rising >> 8;
+    uint32_t down = ( ( from | LaneCarry ) - to ) & LaneMask & ~rising;
+
+    // only one of up and down is set in each lane
+    uint32_t step = div255Lanes( ( ( up & rising ) | down ) * level );
+    return from + ( step & rising ) - ( step & ~rising );
+}
+
+// dst + src, saturating at 255
+inline uint32_t addLanes( uint32_t dst, uint32_t src )
+{
+    uint32_t sum = dst + src;
+    uint32_t carry = ( sum >> 8 ) & ( LaneCarry >> 8 );
+    return ( sum | ( carry * 0xff ) ) & LaneMask;
+}
+
+// the larger of dst and src in each lane
+inline uint32_t maxLanes( uint32_t dst, uint32_t src )
+{
+    // the guard bit survives the subtract only where dst >= src
+    uint32_t keep = ( ( ( dst | LaneCarry ) - src ) >> 8 ) & ( LaneCarry >> 8 );
+    keep *= 0xff;
+    return ( dst & keep ) | ( src & ~keep );
+}
+
+// a * b / 255, rounded
+inline uint32_t multiply( uint32_t a, uint32_t b )
+{
+    uint32_t x = a * b + 128;
+    return ( x + ( x >> 8 ) ) >> 8;
+}
+
+// apply fn to the even and odd lanes of each pixel
+template< typename Fn >
+inline void eachLane( std::span< rgb32_t > dst, std::span< const rgb32_t > src, Fn fn )
+{
+    const size_t count = std::min( dst.size( ), src.size( ) );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        uint32_t d = dst[ i ].packed, s = src[ i ].packed;
+        dst[ i ].packed = fn( even( d ), even( s ) ) | ( fn( odd( d ), odd( s ) ) << 8 );
+    }
+}
+
+} // namespace
+
+void OverFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha )
+{
+    if ( alpha >= 256 )
+    {
+        std::copy( src.begin( ), src.begin( ) + std::min( dst.size( ), src.size( ) ), dst.begin( ) );
+    }
+    else if ( alpha )
+    {
+        eachLane( dst, src, [ = ]( uint32_t d, uint32_t s )
+        {
+            return overLanes( d, s, alpha );
+        } );
+    }
+}
+
+void AddFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha )
+{
+    if ( alpha >= 256 )
+    {
+        eachLane( dst, src, addLanes );
+    }
+    else if ( alpha )
+    {
+        eachLane( dst, src, [ = ]( uint32_t d, uint32_t s )
+        {
+            return addLanes( d, scaleLanes( s, alpha ) );
+        } );
+    }
+}
+
+void MaxFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha )
+{
+    if ( alpha >= 256 )
+    {
+        eachLane( dst, src, maxLanes );
+    }
+    else if ( alpha )
+    {
+        eachLane( dst, src, [ = ]( uint32_t d, uint32_t s )
+        {
+            return maxLanes( d, scaleLanes( s, alpha ) );
+        } );
+    }
+}
+
+void MultiplyFrame( std::span< rgb32_t > dst, std::span< const rgb32_t > src, uint16_t alpha )
+{
+    if ( !alpha )
+    {
+        return;
+    }
+
+    // channels have different multipliers, so this one goes a channel at a time,
+    // then fades from dst to the product
+    alpha = std::min< uint16_t >( alpha, 256 );
+    const size_t count = std::min( dst.size( ), src.size( ) );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        uint32_t d = dst[ i ].packed, s = src[ i ].packed;
+        uint32_t product = multiply( d & 0xff, s & 0xff ) | ( multiply( ( d >> 8 ) & 0xff, ( s >> 8 ) & 0xff ) << 8 ) |
+            ( multiply( ( d >> 16 ) & 0xff, ( s >> 16 ) & 0xff ) << 16 ) | ( multiply( d >> 24, s >> 24 ) << 24 );
+        dst[ i ].packed = overLanes( even( d ), even( product ), alpha ) |
+            ( overLanes( odd( d ), odd( product ), alpha ) << 8 );
+    }
+}
+
+void FadeFrame( std::span< rgb32_t > pixels, uint8_t level )
+{
+    // the unused byte is in the odd lanes, cleared as rgb32_t( r, g, b ) does
+    for ( auto& pixel : pixels )
+    {
+        uint32_t p = pixel.packed;
+        pixel.packed = ( div255Lanes( even( p ) * level ) | ( div255Lanes( odd( p ) * level ) << 8 ) ) & 0x00ffffff;
+    }
+}
+
+void BlurFrame( std::span< rgb32_t > pixels, uint8_t amount )
+{
+    if ( !amount || pixels.empty( ) )
+    {
+        return;
+    }
+
+    // weights out of 256, the sum of each lane stays under 16 bits
+    const uint32_t side = ( amount * 85 ) >> 8, center = 256 - 2 * side;
+    auto mix = [ = ]( uint32_t previous, uint32_t pixel, uint32_t next )
+    {
+        return ( ( ( previous + next ) * side + pixel * center ) >> 8 ) & LaneMask;
+    };
+
+    // in place, keeping the unblurred pixel for the next one's neighbour
+    uint32_t previous = pixels[ 0 ].packed;
+    for ( size_t i = 0; i < pixels.size( ); ++i )
+    {
+        uint32_t pixel = pixels[ i ].packed;
+        uint32_t next = ( i + 1 < pixels.size( ) ) ? pixels[ i + 1 ].packed : pixel;
+        pixels[ i ].packed = mix( even( previous ), even( pixel ), even( next ) ) |
+            ( mix( odd( previous ), odd( pixel ), odd( next ) ) << 8 );
+        previous = pixel;
+    }
+}
+
+void BlendFrames( std::span< rgb32_t > dst, std::span< const rgb32_t > from, std::span< const rgb32_t > to,
+    uint8_t level )
+{
+    const size_t count = std::min( dst.size( ), std::min( from.size( ), to.size( ) ) );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        uint32_t f = from[ i ].packed, t = to[ i ].packed;
+        dst[ i ].packed = ( blendLanes( even( f ), even( t ), level ) |
+            ( blendLanes( odd( f ), odd( t ), level ) << 8 ) ) & 0x00ffffff;
+    }
+}
+
+} // namespace Color
@@ -0,0 +1,98 @@
+#include "color/HSV.h"
+
+
+namespace Color
+{
+
+namespace
+{
+
+// the six spans of the color wheel, each a ramp up or down of one channel
+// between two of red, yellow, green, cyan, blue and magenta
+constexpr uint8_t SpanStart[ 6 ] = { 0, 42, 85, 127, 170, 212 };
+// 255 / span width in 16.16 fixed point, rounded up so whole ramp steps come out exact
+constexpr uint32_t SpanScale[ 6 ] = { 255 * 65536 / 42 + 1, 255 * 65536 / 43 + 1, 255 * 65536 / 42 + 1,
+    255 * 65536 / 43 + 1, 255 * 65536 / 42 + 1, 255 * 65536 / 44 + 1 };
+// where the channel at full goes, and the ramping channel
+constexpr uint8_t FullShift[ 6 ] = { 16, 8, 8, 0, 0, 16 };
+constexpr uint8_t RampShift[ 6 ] = { 8, 16, 0, 8, 16, 0 };
+
+// x / 255, rounded down, for x up to 255 * 255
+inline uint32_t div255( uint32_t x )
+{
+    return ( x + ( x >> 8 ) + 1 ) >> 8;
+}
+
+// a full color desaturated by s and scaled by v
+inline rgb32_t saturate( rgb32_t color, uint8_t s, uint8_t v )
+{
+    if ( ( s & v ) == 255 )
+    {
+        return color;
+    }
+    const uint32_t white = 255 * ( 255 - s );
+    auto channel = [ = ]( uint32_t c )
+    {
+        return div255( div255( c * s + white ) * v );
+    };
+    return rgb32_t( channel( color.r( ) ), channel( color.g( ) ), channel( color.b( ) ) );
+}
+
+} // namespace
+
+rgb32_t HueToRgb( uint8_t hue )
+{
+    // which span, then how far along it, ramping down on the odd spans
+    const int span = ( hue > 42 ) + ( hue > 85 ) + ( hue > 127 ) + ( hue > 170 ) + ( hue > 212 );
+    uint32_t ramp = ( ( hue - SpanStart[ span ] ) * SpanScale[ span ] ) >> 16;
+    ramp ^= -( span & 1 ) & 0xff;
+
+    rgb32_t color;
+    color.packed = ( 255u << FullShift[ span ] ) | ( ramp << RampShift[ span ] );
+    return color;
+}
+
+const Palette& HuePalette( )
+{
+    static const Palette hues = [ ]( )
+    {
+        Palette palette;
+        for ( size_t hue = 0; hue < palette.size( ); ++hue )
+        {
+            palette[ hue ] = HueToRgb( hue );
+        }
+        return palette;
+    }( );
+    return hues;
+}
+
+rgb32_t HsvToRgb( hsv32_t hsv )
+{
+    return saturate( HueToRgb( hsv.h( ) ), hsv.s( ), hsv.v( ) );
+}
+
+rgb32_t HsvToRgb( hsv32_t hsv, const Palette& hues )
+{
+    return saturate( hues[ hsv.h( ) ], hsv.s( ), hsv.v( ) );
+}
+
+void HsvToRgb( std::span< const hsv32_t > hsv, std::span< rgb32_t > rgb, const Palette *hues )
+{
+    const size_t count = std::min( hsv.size( ), rgb.size( ) );
+    if ( hues )
+    {
+        for ( size_t i = 0; i < count; ++i )
+        {
+            rgb[ i ] = saturate( ( *hues )[ hsv[ i ].h( ) ], hsv[ i ].s( ), hsv[ i ].v( ) );
+        }
+    }
+    else
+    {
+        for ( size_t i = 0; i < count; ++i )
+        {
+            rgb[ i ] = saturate( HueToRgb( hsv[ i ].h( ) ), hsv[ i ].s( ), hsv[ i ].v( ) );
+        }
+    }
+}
+
+} // namespace Color
@@ -1,6 +1,7 @@
+#include <algorithm>
 #include <utility>
-#include <cstdlib> // rand
 
+#include "color/HSV.h"
 #include "color/RGB.h"
 
 
@@ -10,11 +11,13 @@ namespace Color
 Gradient::Gradient()
     : m_stepCount( 0 )
 {
+    m_palette.fill( 0 );
 }
 
 void Gradient::clearSteps( )
 {
     m_stepCount = 0;
+    rebuild( );
 }
 
 void Gradient::addStep( uint8_t pos, rgb32_t color )
@@ -24,19 +27,31 @@ void Gradient::addStep( uint8_t pos, rgb32_t color )
         m_steps[ m_stepCount ].pos = pos;
         m_steps[ m_stepCount ].color = color;
         m_stepCount++;
+        rebuild( );
     }
 }
 
-void Gradient::setSteps( Step *steps, uint8_t stepCount )
+void Gradient::setSteps( const Step *steps, uint8_t stepCount )
 {
-    m_stepCount = std::min< uint8_t >( stepCount, m_steps.size( ) );
+    stepCount = std::min< uint8_t >( stepCount, m_steps.size( ) );
+    if ( stepCount == m_stepCount && std::equal( steps, steps + stepCount, m_steps.begin( ),
+        []( const Step& a, const Step& b )
+        {
+            return a.pos == b.pos && a.color == b.color;
+        } ) )
+    {
+        return;
+    }
+
+    m_stepCount = stepCount;
     for ( int i = 0; i < m_stepCount; ++i )
     {
         m_steps[ i ] = steps[ i ];
     }
+    rebuild( );
 }
 
-rgb32_t Gradient::getColor( uint8_t pos )
+rgb32_t Gradient::interpolate( uint8_t pos ) const
 {
     if ( pos <= m_steps[ 0 ].pos ) 
     {
@@ -69,83 +84,19 @@ rgb32_t Gradient::getColor( uint8_t pos )
     }
 }
 
-/*
-
-void Gradient::smear()
+void Gradient::rebuild( )
 {
-    uint8_t prevVal, savePixel;
-    uint16_t _numPixels = strip->numPixels();
-    if (!strip || !strip->numPixels( ) || !_pixels)
+    if ( !m_stepCount )
     {
+        m_palette.fill( 0 );
         return;
     }
-    _pixels[0] = (uint8_t)((int)(_pixels[0] + _pixels[1])/3);
-    prevVal = _pixels[0];
-    for (int i=1; i < _numPixels - 1; i++)
-    {
-        savePixel = _pixels[i];
-        _pixels[i] = (uint8_t)((int)(_pixels[i] + _pixels[i+1] + prevVal)/3);
-        prevVal = savePixel;
-    }
-    _pixels[_numPixels-1] = (uint8_t)((int)(_pixels[_numPixels] + _pixels[prevVal])/3);
-    updateStrip();
-}
-
-void Gradient::randomize()
-{
-    for (int i=0; i < strip->numPixels( ); i++)
+    for ( size_t pos = 0; pos < m_palette.size( ); ++pos )
     {
-        _pixels[i] = random(255);
+        m_palette[ pos ] = interpolate( pos );
     }
-    updateStrip();
 }
 
-void Gradient::randomize(int low, int high)
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        _pixels[i] = random(low, high);
-    }
-    updateStrip();
-}
-
-void Gradient::peturb(int low, int high)
-{
-    int temp;
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        temp = _pixels[i] + (random(low, high));
-        if (temp < 0) temp = 0;
-        if (temp > 255) temp = 255;
-        _pixels[i] = temp;
-    }
-    updateStrip();
-}
-
-void Gradient::fade()
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        if (_pixels[i] < 4)
-            _pixels[i] = 0;
-        else
-            _pixels[i] -= 4;
-    }
-    updateStrip();
-}
-
-void Gradient::wipe(byte level)
-{
-    for (int i=0; i < strip->numPixels( ); i++)
-    {
-        _pixels[i] = level;
-    }
-    updateStrip();
-}
-
-*/
-
-
 rgb32_t ColorFade( rgb32_t c, uint8_t v )
 {
     return rgb32_t( fade( 0, c.r( ), v ), fade( 0, c.g( ), v ), fade( 0, c.b( ), v ) );    
@@ -156,59 +107,15 @@ rgb32_t ColorBlend( rgb32_t c1, rgb32_t c2, uint8_t v )
     return rgb32_t( fade( c1.r( ), c2.r( ), v ), fade( c1.g( ), c2.g( ), v ), fade( c1.b( ), c2.b( ), v ) );    
 }
 
-rgb32_t ColorRandom( )
+rgb32_t ColorRandom( uint32_t random )
 {
-    return ColorWheel( std::rand( ) % 256 );
+    // the top bits, they're the best mixed from simple generators
+    return HsvToRgb( hsv32_t( random >> 24 ), HuePalette( ) );
 }
 
-
-int fade( int outlow, int outhigh, int in, int inlow, int inhigh )
-{
-    return ( outhigh - outlow ) * ( in - inlow ) / ( inhigh - inlow ) + outlow;
-}
-
-struct Hue
-{
-    enum
-    {
-        Red = 0,
-        Yellow = 42,
-        Green = 85,
-        Cyan = 127,
-        Blue = 170,
-        Magenta = 212,
-        RedWrap = 256,  // yes, 256
-    };
-};
-
-// --> someday this will grow up to be an hsv32_t, and an rgb32_t ctor taking hsv32_t
-
 rgb32_t ColorWheel( uint8_t hue )
 {
-    if ( hue <= Hue::Yellow )
-    {
-        return rgb32_t( 255, fade( 0, 255, hue, Hue::Red, Hue::Yellow ), 0 );
-    }
-    else if( hue <= Hue::Green )
-    {
-        return rgb32_t( fade( 255, 0, hue, Hue::Yellow, Hue::Green ), 255, 0 );
-    }
-    else if( hue <= Hue::Cyan )
-    {
-        return rgb32_t( 0, 255, fade( 0, 255, hue, Hue::Green, Hue::Cyan ) );
-    }
-    else if( hue <= Hue::Blue )
-    {
-        return rgb32_t( 0, fade( 255, 0, hue, Hue::Cyan, Hue::Blue ), 255 );
-    }
-    else if( hue <= Hue::Magenta )
-    {
-        return rgb32_t( fade( 0, 255, hue, Hue::Blue, Hue::Magenta ), 0, 255 );
-    }
-    else
-    {
-        return rgb32_t( 255, 0, fade( 255, 0, hue, Hue::Magenta, Hue::RedWrap ) );
-    }
+    return HuePalette( )[ hue ];
 }
 
 } // namespace Color
@@ -0,0 +1,67 @@
+#include "patterns/Benchmark.h"
+
+
+namespace Pattern
+{
+
+bool Benchmark::available( uint8_t pattern )
+{
+    if ( pattern >= Bytecode && pattern < Bytecode + ProgramStore::Slots )
+    {
+        return !Programs( ).program( pattern - Bytecode ).empty( );
+    }
+    return pattern <= Test;
+}
+
+Benchmark::Result Benchmark::run( const Case& test, uint32_t frames )
+{
+    // set up outside the timing
+    BufferStrip strip( test.pixels );
+    PatternStorage storage;
+    auto pattern( CreatePattern( test.pattern, storage ) );
+    m_scratch.resize( test.pixels * Pattern::ScratchPerPixel );
+    pattern->setScratch( m_scratch );
+    pattern->setColor( 0, Color::rgb32_t::Red( ) );
+    pattern->setColor( 1, Color::rgb32_t::White( ) );
+    pattern->setColor( 2, Color::rgb32_t::Green( ) );
+    pattern->setLevel( 0, test.level );
+    const uint64_t duration = std::max< ms_t >( pattern->GetDuration( &strip ), 1 );
+
+    // time through the loops in 1/100 ms, ie at speed percent
+    uint64_t position = 0;
+    auto frameAt = [ & ]( )
+    {
+        uint64_t ms = position / 100;
+        Frame frame;
+        frame.loop = ms / duration;
+        frame.offset = ms % duration;
+        frame.phase = ( ( uint64_t )frame.offset << 16 ) / duration;
+        return frame;
+    };
+
+    Result result{ test, frames, 0, 0 };
+    uint64_t start = m_clock( );
+    pattern->Init( &strip, frameAt( ) );
+    result.init = m_clock( ) - start;
+
+    uint32_t loop = 0;
+    start = m_clock( );
+    for ( uint32_t i = 0; i < frames; ++i )
+    {
+        position += m_period * test.speed;
+        auto frame( frameAt( ) );
+        if ( frame.loop != loop )
+        {
+            loop = frame.loop;
+            pattern->Loop( &strip, frame );
+        }
+        else
+        {
+            pattern->Update( &strip, frame );
+        }
+    }
+    result.render = m_clock( ) - start;
+    return result;
+}
+
+} // namespace Pattern
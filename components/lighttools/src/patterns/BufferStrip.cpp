@@ -0,0 +1,44 @@
+#include "patterns/BufferStrip.h"
+
+
+namespace Pattern
+{
+
+void BufferStrip::fillRange( uint16_t first, uint16_t count, Color::rgb32_t color )
+{
+    // only track the pixels that actually changed
+    int changed = -1, last = 0;
+    for ( int i = first; i < first + count; ++i )
+    {
+        if ( m_pixels[ i ] != color )
+        {
+            m_pixels[ i ] = color;
+            changed = ( changed < 0 ) ? i : changed;
+            last = i;
+        }
+    }
+    if ( changed >= 0 )
+    {
+        markDirty( changed, last + 1 - changed );
+    }
+}
+
+void BufferStrip::writePixels( std::span< const Color::rgb32_t > colors, uint16_t first )
+{
+    int changed = -1, last = 0;
+    for ( int i = 0; i < ( int )colors.size( ); ++i )
+    {
+        if ( m_pixels[ first + i ] != colors[ i ] )
+        {
+            m_pixels[ first + i ] = colors[ i ];
+            changed = ( changed < 0 ) ? first + i : changed;
+            last = first + i;
+        }
+    }
+    if ( changed >= 0 )
+    {
+        markDirty( changed, last + 1 - changed );
+    }
+}
+
+} // namespace Pattern
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include "patterns/CompositeStrip.h"
+
+
+namespace Pattern
+{
+
+void CompositeStrip::addSegment( const Segment& segment )
+{
+    m_segments.push_back( segment );
+    resize( numPixels( ) + segment.length );
+
+    if ( std::find( m_channels.begin( ), m_channels.end( ), segment.channel ) == m_channels.end( ) )
+    {
+        m_channels.push_back( segment.channel );
+        segment.channel->setBrightness( m_brightness );
+        segment.channel->setTransmitDone( channelDone, this );
+    }
+}
+
+std::pair< Strip *, uint16_t > CompositeStrip::map( uint16_t pixel ) const
+{
+    for ( const auto& segment : m_segments )
+    {
+        if ( pixel < segment.length )
+        {
+            uint16_t index = segment.reversed ? ( segment.length - 1 - pixel ) : pixel;
+            return { segment.channel, segment.offset + index };
+        }
+        pixel -= segment.length;
+    }
+    return { nullptr, 0 };
+}
+
+void CompositeStrip::setBrightness( uint8_t bright )
+{
+    BufferStrip::setBrightness( bright );
+    for ( auto channel : m_channels )
+    {
+        channel->setBrightness( bright );
+    }
+}
+
+void CompositeStrip::transmit( )
+{
+    transmitAsync( );
+    waitTransmit( -1 );
+}
+
+void CompositeStrip::transmitAsync( )
+{
+    if ( !startFrame( ) )
+    {
+        return;
+    }
+
+    // the previous frame has to finish before its count is replaced, or its
+    // late callbacks would count against this frame
+    for ( auto channel : m_channels )
+    {
+        channel->waitTransmit( -1 );
+    }
+    copyToChannels( );
+    clearDirty( );
+
+    // a channel that skips its frame never calls back, so channels with no
+    // changed segments send anyway and the count always runs down
+    m_pending = m_channels.size( );
+    for ( auto channel : m_channels )
+    {
+        if ( !channel->isDirty( ) )
+        {
+            channel->markDirty( 0, 1 );
+        }
+        channel->transmitAsync( );
+    }
+}
+
+bool CompositeStrip::waitTransmit( uint32_t timeout )
+{
+    bool done = true;
+    for ( auto channel : m_channels )
+    {
+        done = channel->waitTransmit( timeout ) && done;
+    }
+    return done;
+}
+
+uint32_t CompositeStrip::transmitTime( ) const
+{
+    uint32_t time = 0;
+    for ( auto channel : m_channels )
+    {
+        time = std::max( time, channel->transmitTime( ) );
+    }
+    return time;
+}
+
+void CompositeStrip::copyToChannels( )
+{
+    std::span< const Color::rgb32_t > remaining( m_pixels );
+    uint16_t start = 0;
+    for ( const auto& segment : m_segments )
+    {
+        auto source( remaining.first( segment.length ) );
+        remaining = remaining.subspan( segment.length );
+        start += segment.length;
+
+        // skip segments with no changes
+        if ( start <= dirtyFirst( ) || ( start - segment.length ) >= dirtyEnd( ) )
+        {
+            continue;
+        }
+
+        if ( !segment.reversed )
+        {
+            segment.channel->writePixels( source, segment.offset );
+        }
+        else
+        {
+            auto dest( segment.channel->pixels( ) );
+            if ( !dest.empty( ) )
+            {
+                std::reverse_copy( source.begin( ), source.end( ), dest.begin( ) + segment.offset );
+                segment.channel->markDirty( segment.offset, segment.length );
+            }
+            else
+            {
+                for ( uint16_t i = 0; i < segment.length; ++i )
+                {
+                    segment.channel->setPixelColor( segment.offset + segment.length - 1 - i, source[ i ] );
+                }
+            }
+        }
+    }
+}
+
+void CompositeStrip::channelDone( void *strip )
+{
+    auto composite( static_cast< CompositeStrip * >( strip ) );
+    if ( --composite->m_pending == 0 )
+    {
+        composite->transmitDone( );
+    }
+}
+
+} // namespace Pattern
@@ -0,0 +1,84 @@
+#include "color/Frame.h"
+#include "patterns/Compositor.h"
+
+
+namespace Pattern
+{
+
+Compositor::Compositor( size_t layers )
+    : m_layers( layers )
+{
+}
+
+void Compositor::UpdateLayer( size_t layer, ms_t now, const PlayerControl& control, Blend blend, Strip *strip )
+{
+    auto& current( m_layers[ layer ] );
+    if ( current.pixels.numPixels( ) != strip->numPixels( ) )
+    {
+        current.pixels = BufferStrip( strip->numPixels( ) );
+    }
+    current.pixels.setPixelMap( strip->pixelMap( ) );
+    current.player.UpdatePattern( now, control, &current.pixels );
+    m_changed = m_changed || !current.active || current.blend != blend;
+    current.blend = blend;
+    current.active = true;
+}
+
+void Compositor::ClearLayer( size_t layer )
+{
+    m_changed = m_changed || m_layers[ layer ].active;
+    m_layers[ layer ].active = false;
+}
+
+void Compositor::UpdateStrip( ms_t now, Strip *strip )
+{
+    // render the layers
+    bool changed = m_changed;
+    for ( auto& layer : m_layers )
+    {
+        if ( layer.active )
+        {
+            layer.player.UpdateStrip( now, &layer.pixels );
+            changed = changed || layer.pixels.isDirty( );
+        }
+    }
+    if ( !changed )
+    {
+        return;
+    }
+
+    // and combine them from the bottom up
+    m_frame.resize( strip->numPixels( ) );
+    std::fill( m_frame.begin( ), m_frame.end( ), Color::rgb32_t::Black( ) );
+    for ( auto& layer : m_layers )
+    {
+        if ( !layer.active )
+        {
+            continue;
+        }
+        std::span< const Color::rgb32_t > pixels( layer.pixels.pixels( ) );
+        uint16_t alpha = Color::Alpha( layer.pixels.getBrightness( ) );
+        switch ( layer.blend )
+        {
+        case Blend::Over:
+            Color::OverFrame( m_frame, pixels, alpha );
+            break;
+        case Blend::Add:
+            Color::AddFrame( m_frame, pixels, alpha );
+            break;
+        case Blend::Max:
+            Color::MaxFrame( m_frame, pixels, alpha );
+            break;
+        case Blend::Multiply:
+            Color::MultiplyFrame( m_frame, pixels, alpha );
+            break;
+        }
+
+        // the layer's changes are in this frame
+        layer.pixels.transmit( );
+    }
+    strip->writePixels( m_frame );
+    m_changed = false;
+}
+
+} // namespace Pattern
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include "color/Frame.h"
+#include "patterns/EffectStrip.h"
+
+
+namespace Pattern
+{
+
+EffectStrip::EffectStrip( Strip *output )
+    : BufferStrip( output->numPixels( ) ), m_output( output )
+{
+    m_sizes[ 0 ] = output->numPixels( );
+    m_output->setBrightness( m_brightness );
+    m_output->setTransmitDone( outputDone, this );
+}
+
+void EffectStrip::setEffects( std::span< const Effect > effects )
+{
+    m_effectCount = std::min( effects.size( ), MaxEffects );
+    std::copy( effects.begin( ), effects.begin( ) + m_effectCount, m_effects.begin( ) );
+
+    // work back from the output to the pixels rendered
+    m_sizes[ m_effectCount ] = m_output->numPixels( );
+    for ( size_t i = m_effectCount; i > 0; --i )
+    {
+        const auto& effect( m_effects[ i - 1 ] );
+        uint16_t size = m_sizes[ i ];
+        if ( effect.type == Effect::Mirror )
+        {
+            size = ( size + 1 ) / 2;
+        }
+        else if ( effect.type == Effect::Repeat && effect.amount )
+        {
+            size = std::min( size, effect.amount );
+        }
+        m_sizes[ i - 1 ] = size;
+    }
+    resize( m_sizes[ 0 ] );
+    m_trail.clear( );
+    m_fading = false;
+    markDirty( );
+}
+
+void EffectStrip::setBrightness( uint8_t bright )
+{
+    BufferStrip::setBrightness( bright );
+    m_output->setBrightness( bright );
+}
+
+void EffectStrip::transmit( )
+{
+    transmitAsync( );
+    waitTransmit( -1 );
+}
+
+void EffectStrip::transmitAsync( )
+{
+    // trails change the frame even when the pattern doesn't
+    if ( m_fading )
+    {
+        markDirty( );
+    }
+    if ( !startFrame( ) )
+    {
+        return;
+    }
+    clearDirty( );
+
+    // process in place in the output's pixels if it keeps them
+    auto frame( m_output->pixels( ) );
+    if ( frame.empty( ) )
+    {
+        m_frame.resize( m_output->numPixels( ) );
+        frame = m_frame;
+    }
+    std::copy( m_pixels.begin( ), m_pixels.begin( ) + std::min( m_pixels.size( ), frame.size( ) ), frame.begin( ) );
+    process( frame );
+    if ( frame.data( ) == m_frame.data( ) )
+    {
+        m_output->writePixels( frame );
+    }
+    else
+    {
+        m_output->markDirty( );
+    }
+    m_output->transmitAsync( );
+}
+
+bool EffectStrip::waitTransmit( uint32_t timeout )
+{
+    return m_output->waitTransmit( timeout );
+}
+
+uint32_t EffectStrip::transmitTime( ) const
+{
+    return m_output->transmitTime( );
+}
+
+void EffectStrip::process( std::span< Color::rgb32_t > frame )
+{
+    size_t decays = 0;
+    m_fading = false;
+    for ( size_t i = 0; i < m_effectCount; ++i )
+    {
+        const auto& effect( m_effects[ i ] );
+        auto pixels( frame.first( std::min< size_t >( m_sizes[ i ], frame.size( ) ) ) );
+        auto grown( frame.first( std::min< size_t >( m_sizes[ i + 1 ], frame.size( ) ) ) );
+        switch ( effect.type )
+        {
+        case Effect::Mirror:
+            for ( size_t j = pixels.size( ); j < grown.size( ); ++j )
+            {
+                grown[ j ] = grown[ grown.size( ) - 1 - j ];
+            }
+            break;
+
+        case Effect::Reverse:
+            std::reverse( pixels.begin( ), pixels.end( ) );
+            break;
+
+        case Effect::Repeat:
+            // copy what's been tiled so far, doubling each time
+            for ( size_t length = pixels.size( ); length && length < grown.size( ); length *= 2 )
+            {
+                std::copy_n( grown.begin( ), std::min( length, grown.size( ) - length ), grown.begin( ) + length );
+            }
+            break;
+
+        case Effect::Blur:
+            Color::BlurFrame( pixels, effect.amount );
+            break;
+
+        case Effect::Decay:
+        {
+            // the faded last frame shows through wherever it's brighter, the
+            // trails for each Decay are kept one after the other
+            const size_t start = decays;
+            decays += pixels.size( );
+            if ( m_trail.size( ) < decays )
+            {
+                m_trail.resize( decays );
+            }
+            std::span< Color::rgb32_t > trail( m_trail.data( ) + start, pixels.size( ) );
+
+            // fading by at least 1 each frame takes every channel down by at
+            // least a step, so the trails always reach black
+            const uint8_t fade = std::clamp< uint16_t >( effect.amount, 1, 255 );
+            Color::FadeFrame( trail, 255 - fade );
+
+            // only a trail brighter than the frame somewhere shows, and keeps
+            // frames coming, a still frame fades below itself and is skipped
+            const bool shows = !std::equal( pixels.begin( ), pixels.end( ), trail.begin( ),
+                []( Color::rgb32_t pixel, Color::rgb32_t faded )
+                {
+                    return pixel.r( ) >= faded.r( ) && pixel.g( ) >= faded.g( ) && pixel.b( ) >= faded.b( );
+                } );
+            if ( shows )
+            {
+                Color::MaxFrame( pixels, trail );
+                m_fading = true;
+            }
+            std::copy( pixels.begin( ), pixels.end( ), trail.begin( ) );
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+void EffectStrip::outputDone( void *strip )
+{
+    static_cast< EffectStrip * >( strip )->transmitDone( );
+}
+
+} // namespace Pattern
@@ -0,0 +1,121 @@
+#include "patterns/HostStrip.h"
+
+
+namespace Pattern
+{
+
+HostStrip::HostStrip( uint16_t size, size_t maxFrames )
+    : BufferStrip( size ), m_maxFrames( maxFrames )
+{
+}
+
+HostStrip::~HostStrip( )
+{
+    close( );
+}
+
+void HostStrip::transmit( )
+{
+    if ( !startFrame( ) )
+    {
+        return;
+    }
+    clearDirty( );
+
+    // keep it in memory
+    if ( m_maxFrames )
+    {
+        if ( m_times.size( ) >= m_maxFrames )
+        {
+            m_times.erase( m_times.begin( ) );
+            m_frames.erase( m_frames.begin( ), m_frames.begin( ) + frameSize( ) );
+        }
+        m_times.push_back( m_now );
+        for ( const auto& pixel : m_pixels )
+        {
+            m_frames.push_back( pixel.r( ) );
+            m_frames.push_back( pixel.g( ) );
+            m_frames.push_back( pixel.b( ) );
+        }
+    }
+
+    // and in the file
+    if ( m_file )
+    {
+        m_index.push_back( m_now );
+        m_index.push_back( ftell( m_file ) );
+        write32( m_now );
+        fputc( m_brightness, m_file );
+        for ( const auto& pixel : m_pixels )
+        {
+            uint8_t rgb[ 3 ] = { pixel.r( ), pixel.g( ), pixel.b( ) };
+            fwrite( rgb, sizeof( rgb ), 1, m_file );
+        }
+    }
+
+    transmitDone( );
+}
+
+void HostStrip::clearFrames( )
+{
+    m_times.clear( );
+    m_frames.clear( );
+}
+
+bool HostStrip::record( const char *path )
+{
+    close( );
+    m_file = fopen( path, "wb" );
+    if ( !m_file )
+    {
+        return false;
+    }
+
+    // header, frame count and index offset are filled in by close()
+    fwrite( "RPXF", 4, 1, m_file );
+    write16( FileVersion );
+    write16( numPixels( ) );
+    write32( 0 );
+    write32( 0 );
+    return true;
+}
+
+bool HostStrip::close( )
+{
+    if ( !m_file )
+    {
+        return false;
+    }
+
+    // index
+    uint32_t indexOffset = ftell( m_file );
+    for ( auto value : m_index )
+    {
+        write32( value );
+    }
+
+    // complete the header
+    fseek( m_file, 8, SEEK_SET );
+    write32( m_index.size( ) / 2 );
+    write32( indexOffset );
+
+    bool ok = !ferror( m_file );
+    ok = ( fclose( m_file ) == 0 ) && ok;
+    m_file = nullptr;
+    m_index.clear( );
+    return ok;
+}
+
+void HostStrip::write16( uint16_t value )
+{
+    fputc( value & 0xff, m_file );
+    fputc( value >> 8, m_file );
+}
+
+void HostStrip::write32( uint32_t value )
+{
+    write16( value & 0xffff );
+    write16( value >> 16 );
+}
+
+} // namespace Pattern
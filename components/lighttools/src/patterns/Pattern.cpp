@@ -1,11 +1,53 @@
 #include <math.h>
-#include <cstdlib> // rand
+#include <iterator>
+#include "color/HSV.h"
 #include "patterns/Pattern.h"
 
 
 namespace Pattern
 {
 
+namespace
+{
+
+// Steps through i * numerator / denominator for i = start, start + 1 ... without dividing
+class Ramp
+{
+public:
+    Ramp( uint32_t numerator, uint32_t denominator, uint32_t start = 0 )
+        : m_value( start * numerator / denominator ), m_remainder( start * numerator % denominator ),
+          m_step( numerator / denominator ), m_remainderStep( numerator % denominator ),
+          m_denominator( denominator )
+    {
+    }
+
+    // returns the current value and steps to the next
+    uint32_t next( )
+    {
+        uint32_t value = m_value;
+        m_value += m_step;
+        m_remainder += m_remainderStep;
+        if ( m_remainder >= m_denominator )
+        {
+            m_remainder -= m_denominator;
+            ++m_value;
+        }
+        return value;
+    }
+
+    // back to i = 0
+    void reset( )
+    {
+        m_value = m_remainder = 0;
+    }
+
+private:
+    uint32_t m_value, m_remainder;
+    uint32_t m_step, m_remainderStep, m_denominator;
+};
+
+} // namespace
+
 Pattern::Pattern( )
 {
     m_color[ 0 ] = Color::rgb32_t::Red( );
@@ -17,35 +59,132 @@ Pattern::Pattern( )
 
 //-------------------------------------------------------------
 
-Pattern *CreatePattern( uint8_t pattern )
+template< typename Fn >
+void Pattern::renderStrip( Strip *strip, Fn render )
+{
+    auto pixels( strip->pixels( ) );
+    bool copy( pixels.empty( ) );
+    if ( copy )
+    {
+        // render into the caller's copy and write out the changes
+        if ( m_stripPixels.size( ) < strip->numPixels( ) )
+        {
+            return;
+        }
+        pixels = m_stripPixels.first( strip->numPixels( ) );
+    }
+
+    m_changedFirst = pixels.size( );
+    m_changedEnd = 0;
+    render( pixels );
+    if ( m_changedFirst < m_changedEnd )
+    {
+        if ( copy )
+        {
+            strip->writePixels( pixels.subspan( m_changedFirst, m_changedEnd - m_changedFirst ), m_changedFirst );
+        }
+        else
+        {
+            strip->markDirty( m_changedFirst, m_changedEnd - m_changedFirst );
+        }
+    }
+}
+
+void Pattern::Init( Strip *strip, const Frame& frame )
+{
+    renderStrip( strip, [ & ]( std::span< Color::rgb32_t > pixels )
+    {
+        RenderInit( pixels, frame );
+    } );
+}
+
+void Pattern::Loop( Strip *strip, const Frame& frame )
+{
+    renderStrip( strip, [ & ]( std::span< Color::rgb32_t > pixels )
+    {
+        RenderLoop( pixels, frame );
+    } );
+}
+
+void Pattern::Update( Strip *strip, const Frame& frame )
+{
+    renderStrip( strip, [ & ]( std::span< Color::rgb32_t > pixels )
+    {
+        Render( pixels, frame );
+    } );
+}
+
+//-------------------------------------------------------------
+
+Pattern *CreatePattern( uint8_t pattern, PatternStorage& storage )
+{
+    switch ( pattern )
+    {
+    case MiniTwinkle:
+        return &storage.emplace< MiniTwinklePattern >( );
+    case MiniSparkle:
+        return &storage.emplace< MiniSparklePattern >( );
+    case Sparkle:
+        return &storage.emplace< SparklePattern >( );
+    case Rainbow:
+        return &storage.emplace< RainbowPattern >( );
+    case Flash:
+        return &storage.emplace< FlashPattern >( );
+    case March:
+        return &storage.emplace< MarchPattern >( );
+    case Wipe:
+        return &storage.emplace< WipePattern >( );
+    case Gradient:
+        return &storage.emplace< GradientPattern >( );
+    case Fixed:
+        return &storage.emplace< FixedPattern >( );
+    case Strobe:
+        return &storage.emplace< StrobePattern >( );
+    case CandyCane:
+        return &storage.emplace< CandyCanePattern >( );
+    case Test:
+    default:
+        if ( pattern >= Bytecode && pattern < Bytecode + ProgramStore::Slots )
+        {
+            return &storage.emplace< ProgramPattern >( pattern - Bytecode );
+        }
+        return &storage.emplace< TestPattern >( );
+    }
+}
+
+const char *PatternName( uint8_t pattern )
 {
     switch ( pattern )
     {
     case MiniTwinkle:
-        return new MiniTwinklePattern( );
+        return "MiniTwinkle";
     case MiniSparkle:
-        return new MiniSparklePattern( );
+        return "MiniSparkle";
     case Sparkle:
-        return new SparklePattern( );
+        return "Sparkle";
     case Rainbow:
-        return new RainbowPattern( );
+        return "Rainbow";
     case Flash:
-        return new FlashPattern( );
+        return "Flash";
     case March:
-        return new MarchPattern( );
+        return "March";
     case Wipe:
-        return new WipePattern( );
+        return "Wipe";
     case Gradient:
-        return new GradientPattern( );
+        return "Gradient";
     case Fixed:
-        return new FixedPattern( );
+        return "Fixed";
     case Strobe:
-        return new StrobePattern( );
+        return "Strobe";
     case CandyCane:
-        return new CandyCanePattern( );
+        return "CandyCane";
     case Test:
     default:
-        return new TestPattern( );
+        if ( pattern >= Bytecode && pattern < Bytecode + ProgramStore::Slots )
+        {
+            return "Bytecode";
+        }
+        return "Test";
     }
 }
 
@@ -53,26 +192,26 @@ Pattern *CreatePattern( uint8_t pattern )
 
 ms_t FlashPattern::GetDuration( Strip * )
 {
-    return 4000;
+    return Duration;
 }
 
-void FlashPattern::Update( Strip *strip, ms_t offset )
+void FlashPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    uint16_t t = offset * 300 / GetDuration( strip );
+    uint16_t t = ( frame.phase * 300 ) >> 16;
     uint16_t o = t % 100;
     Color::rgb32_t col = color( t / 100 );
     if ( ( o <= 10 ) || ( o >= 20 && o <= 30 ) )
     {
-        strip->setAllColor( col );
+        fill( pixels, col );
     }
     else if ( o > 30 && o <= 60 )
     {
         uint8_t f = ( 60 - o ) * 255 / 30;
-        strip->setAllColor( Color::ColorFade( col, f ) );
+        fill( pixels, Color::ColorFade( col, f ) );
     }
     else
     {
-        strip->setAllColor( 0 );
+        fill( pixels, 0 );
     }
 }
 
@@ -80,49 +219,71 @@ void FlashPattern::Update( Strip *strip, ms_t offset )
 
 ms_t RainbowPattern::GetDuration( Strip * )
 {
-    return 2000;
+    return Duration;
 }
 
-void RainbowPattern::Update( Strip *strip, ms_t offset )
+void RainbowPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    if ( pixels.empty( ) )
     {
-        uint8_t t = 255 - offset * 255 / GetDuration( strip );
-        uint8_t p = i * 255 / strip->numPixels( );
-        strip->setPixelColor( i, Color::ColorWheel( ( p + t ) % 255 ) );
+        return;
     }
+
+    const uint8_t t = 255 - ( ( frame.phase * 255 ) >> 16 );
+    const auto& hues( Color::HuePalette( ) );
+
+    // across the layout, along the axis picked by the second level
+    auto points( this->points( pixels ) );
+    if ( !points.empty( ) )
+    {
+        const int axis = m_level[ 1 ] >> 6;
+        generate( pixels, [ & ]( size_t i )
+        {
+            return hues[ ( points[ i ][ axis ] + t ) % 255 ];
+        } );
+        return;
+    }
+
+    Ramp p( 255, pixels.size( ) );
+    generate( pixels, [ & ]( size_t )
+    {
+        // ( p + t ) % 255, p is under 255 and t at most 255 so one step does
+        uint32_t wheel = p.next( ) + t;
+        return hues[ ( wheel >= 255 ) ? ( wheel - 255 ) : wheel ];
+    } );
 }
 
 //-------------------------------------------------------------
 
 ms_t SparklePattern::GetDuration( Strip * )
 {
-    return 100;
+    return Duration;
 }
 
-void SparklePattern::Loop( Strip *strip, ms_t offset )
+void SparklePattern::RenderLoop( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
     // strobe - new pixels each loop
-    strip->setAllColor( 0 );
-    for ( int c = Color::fade( 1, strip->numPixels( ), m_level[ 0 ] ); c; c-- )
+    fill( pixels, 0 );
+    auto rand( random( frame.loop ) );
+    for ( int c = Color::fade( 1, pixels.size( ), m_level[ 0 ] ); c; c-- )
     {
-        Color::rgb32_t col = color( std::rand( ) % 3 );
+        Color::rgb32_t col = color( rand.below( c * 3, 3 ) );
         if ( col == 0 )
-            col = Color::ColorRandom( );
-        strip->setPixelColor( std::rand( ) % strip->numPixels( ), col );
+            col = Color::ColorWheel( rand( c * 3 + 1 ) );
+        set( pixels, rand.below( c * 3 + 2, pixels.size( ) ), col );
     }
 
-    Update( strip, offset );
+    Render( pixels, frame );
 }
 
 //-------------------------------------------------------------
 
-void MiniSparklePattern::Update( Strip *strip, ms_t offset )
+void MiniSparklePattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
     // 25% duty cycle
-    if ( offset > GetDuration( strip ) / 4 )
+    if ( frame.phase > 0x4000 )
     {
-        strip->setAllColor( 0 );
+        fill( pixels, 0 );
     }
 }
 
@@ -132,85 +293,73 @@ MiniTwinklePattern::MiniTwinklePattern()
 {
 }
 
-void MiniTwinklePattern::Init( Strip *strip, ms_t offset )
+void MiniTwinklePattern::RenderInit( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    m_lastDim = m_lastLit = offset;
-    Loop( strip, offset );
+    // start lighting from here, rather than catching up on the loop so far
+    m_lastDim = frame.phase;
+    m_litLoop = frame.loop;
+    m_lit = ( frame.phase * Color::fade( 1, pixels.size( ), m_level[ 0 ] ) ) >> 16;
+    RenderLoop( pixels, frame );
 }
 
 ms_t MiniTwinklePattern::GetDuration( Strip * )
 {
-    return 1000;
+    return Duration;
 }
 
-void MiniTwinklePattern::Update( Strip *strip, ms_t offset )
+void MiniTwinklePattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    int duration( GetDuration( strip ) );
-
-    // dim down all pixels
-    ms_t dimDelta( delta( m_lastDim, offset, duration ) );
-    int dim( 255 - ( dimDelta * 255 / duration ) );
+    // dim down all pixels, by how far we've come since the last time
+    uint16_t dimDelta( frame.phase - m_lastDim );
+    int dim( 255 - ( ( dimDelta * 255 ) >> 16 ) );
     if ( dim < 255 )
     {
-        for ( int i = 0; i < strip->numPixels( ); ++i )
-        {
-            Color::rgb32_t col = strip->getPixelColor( i );
-            col = Color::ColorFade( col, dim );
-            strip->setPixelColor( i, col );
-        }
-        m_lastDim = offset;
+        fade( pixels, dim );
+        m_lastDim = frame.phase;
     }
 
-    // add any new pixels as needed
-    long total( Color::fade( 1, strip->numPixels( ), m_level[ 0 ] ) );
-    ms_t litDelta( delta( m_lastLit, offset, duration ) );
-    long todo( litDelta * total / duration );
-    if ( todo > 0 )
+    // add any new pixels as needed, the nth pixel lit in a loop is the same whenever it's lit
+    long total( Color::fade( 1, pixels.size( ), m_level[ 0 ] ) );
+    auto light = [ & ]( long end )
     {
-        for ( ; todo > 0; todo-- )
+        auto rand( random( m_litLoop ) );
+        for ( ; m_lit < end; m_lit++ )
         {
-            int i = std::rand( ) % strip->numPixels( );
-            Color::rgb32_t col( color( std::rand( ) % 3 ) );
-            strip->setPixelColor( i, col );
+            size_t i = rand.below( m_lit * 2, pixels.size( ) );
+            set( pixels, i, color( rand.below( m_lit * 2 + 1, 3 ) ) );
         }
-        m_lastLit = offset; // only update if we lit something!
-    }
-}
-
-ms_t MiniTwinklePattern::delta( ms_t previous, ms_t next, ms_t duration )
-{
-    if ( next >= previous )
+    };
+    if ( frame.loop != m_litLoop )
     {
-        return next - previous;
-    }
-    else
-    {
-        return duration - previous + next;
+        // finish the last loop
+        light( total );
+        m_litLoop = frame.loop;
+        m_lit = 0;
     }
+    light( ( frame.phase * total ) >> 16 );
 }
 
 //-------------------------------------------------------------
 
 ms_t MarchPattern::GetDuration( Strip * )
 {
-    return 1000;
+    return Duration;
 }
 
-void MarchPattern::Update( Strip *strip, ms_t offset )
+void MarchPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
     // a segment is one color, there are three segments in a loop
 
-    // duration of a loop
-    uint32_t duration = GetDuration( strip );
     // length of each segment?
     uint8_t length = std::max<uint8_t>(m_level[0], 2);
     // how far are we through all three segments
-    uint32_t o = ( length * 3 ) - ( offset * length * 3 / duration );
+    uint32_t o = ( length * 3 ) - ( ( frame.phase * length * 3 ) >> 16 );
 
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    // fade level based on position within segment
+    uint8_t fades[ 256 ];
+    for ( uint32_t position = 0; position < length; ++position )
     {
-        // fade level based on position within segment
-        uint32_t e = ( i + o ) % length;
+        uint32_t e = position;
         if ( e > ( length / 2 ) )
         {
             e = length - e;
@@ -223,35 +372,75 @@ void MarchPattern::Update( Strip *strip, ms_t offset )
         {
             e = 0;
         }
-        uint8_t f = e * 255 / ( length / 2 );
-
-        // color based on segment
-        auto c = color( ( ( i + o ) / length ) % 3 );
-
-        strip->setPixelColor( i, Color::ColorFade( c, f ) );
+        fades[ position ] = e * 255 / ( length / 2 );
     }
+
+    // step through the segments rather than dividing by the length for each pixel
+    uint32_t position = o % length;
+    uint32_t segment = ( o / length ) % 3;
+    generate( pixels, [ & ]( size_t )
+    {
+        auto c = Color::ColorFade( m_color[ segment ], fades[ position ] );
+        if ( ++position == length )
+        {
+            position = 0;
+            segment = ( segment == 2 ) ? 0 : ( segment + 1 );
+        }
+        return c;
+    } );
 }
 
 //-------------------------------------------------------------
 
 ms_t WipePattern::GetDuration( Strip * )
 {
-    return 3000;
+    return Duration;
 }
 
-void WipePattern::Update( Strip *strip, ms_t offset )
+void WipePattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    if ( pixels.empty( ) )
+    {
+        return;
+    }
+
+    // across the layout, along the axis picked by the second level, 256 steps per color
+    auto points( this->points( pixels ) );
+    if ( !points.empty( ) )
     {
-        int d = GetDuration( strip );
-        int t = offset * ( strip->numPixels( ) * 3 ) / d;
-        t = ( strip->numPixels( ) * 3 ) - t; // offset due to time
-        int c = ( i + t ) / strip->numPixels( );
-        int e = ( i + t ) % strip->numPixels( );
-        uint8_t f = e * 255 / strip->numPixels( );
-        f = ( f < 128 ) ? 0 : ( ( f - 128 ) * 2 );
-        strip->setPixelColor( i, Color::ColorFade( color( c ), f ) );
+        const int axis = m_level[ 1 ] >> 6;
+        const int t = 768 - ( ( frame.phase * 768 ) >> 16 );
+        generate( pixels, [ & ]( size_t i )
+        {
+            int s = t + points[ i ][ axis ];
+            int e = s & 255;
+            uint8_t level = ( e < 128 ) ? 0 : ( ( e - 128 ) * 2 );
+            return Color::ColorFade( m_color[ ( s >> 8 ) % 3 ], level );
+        } );
+        return;
     }
+
+    const int count = pixels.size( );
+    int t = ( ( uint64_t )frame.phase * ( count * 3 ) ) >> 16;
+    t = ( count * 3 ) - t; // offset due to time
+
+    // color and position of the first pixel, then step along
+    int c = ( t / count ) % 3;
+    int e = t % count;
+    Ramp f( 255, count, e );
+    generate( pixels, [ & ]( size_t )
+    {
+        uint8_t level = f.next( );
+        level = ( level < 128 ) ? 0 : ( ( level - 128 ) * 2 );
+        auto col = Color::ColorFade( m_color[ c ], level );
+        if ( ++e == count )
+        {
+            e = 0;
+            f.reset( );
+            c = ( c == 2 ) ? 0 : ( c + 1 );
+        }
+        return col;
+    } );
 }
 
 //-------------------------------------------------------------
@@ -271,43 +460,48 @@ GradientPattern::GradientPattern( )
 
 ms_t GradientPattern::GetDuration( Strip * )
 {
-    return 1000;
+    return Duration;
 }
 
-void GradientPattern::Init( Strip *strip, ms_t offset )
+void GradientPattern::RenderInit( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
     // setup gradient
     ResetGradient();
     changed = false;
 
-    // setup maps
-    mp1 = new uint8_t[ strip->numPixels( ) ];
-    mp2 = new uint8_t[ strip->numPixels( ) ];
-    if ( mp1 && mp2 )
+    // setup maps, starting from each pixel's own position
+    const size_t count = pixels.size( );
+    mp1 = mp2 = NULL;
+    if ( m_scratch.size( ) >= count * 2 )
     {
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        mp1 = m_scratch.data( );
+        mp2 = mp1 + count;
+        for ( size_t i = 0; i < count; i++ )
         {
-            mp1[ i ] = mp2[ i ] = i;
+            mp1[ i ] = mp2[ i ] = position( i, count );
         }
     }
-    Loop( strip, offset );
+    RenderLoop( pixels, frame );
 }
 
-void GradientPattern::Loop( Strip *strip, ms_t offset )
+void GradientPattern::RenderLoop( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    // create a new random map
+    // blend from the last loop's map to a new random map, both worked out from
+    // the loop so the pattern can start on any loop
     if ( mp1 && mp2 )
     {
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        const size_t count = pixels.size( );
+        auto rand( random( frame.loop ) ), last( random( frame.loop - 1 ) );
+        for ( size_t i = 0; i < count; i++ )
         {
-            mp1[ i ] = mp2[ i ];
-            mp2[ i ] = std::rand( ) % strip->numPixels( );
+            mp1[ i ] = position( frame.loop ? last.below( i, count ) : i, count );
+            mp2[ i ] = position( rand.below( i, count ), count );
         }
     }
-    Update( strip, offset );
+    Render( pixels, frame );
 }
 
-void GradientPattern::Update( Strip *strip, ms_t offset )
+void GradientPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
     if ( changed )
     {
@@ -315,16 +509,16 @@ void GradientPattern::Update( Strip *strip, ms_t offset )
         changed = false;
     }
 
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    const uint8_t blend = ( frame.phase * 255 ) >> 16;
+    if ( !mp1 || !mp2 )
     {
-        auto c1 = Color::rgb32_t::Red( ), c2 = Color::rgb32_t::Red( );
-        if ( mp1 && mp2 )
-        {
-            c1 = grad.getColor( ( int )mp1[ i ] * 255 / strip->numPixels( ) );
-            c2 = grad.getColor( ( int )mp2[ i ] * 255 / strip->numPixels( ) );
-        }
-        strip->setPixelColor( i, Color::ColorBlend( c1, c2, offset * 255 / GetDuration( strip ) ) );
+        fill( pixels, Color::rgb32_t::Red( ) );
+        return;
     }
+    generate( pixels, [ & ]( size_t i )
+    {
+        return Color::ColorBlend( m_gradient.getColor( mp1[ i ] ), m_gradient.getColor( mp2[ i ] ), blend );
+    } );
 }
 
 void GradientPattern::setColor( int index, Color::rgb32_t _color )
@@ -347,81 +541,83 @@ void GradientPattern::setLevel( int index, uint8_t _level )
 
 void GradientPattern::ResetGradient()
 {
-    grad.clearSteps( );
     if ( m_level[ 0 ] > 6 && m_level[ 0 ] < 249 )
     {
-        grad.addStep( 0, m_color[ 0 ] );
-        grad.addStep( m_level[ 0 ] / 3, m_color[ 1 ] );
-        grad.addStep( ( int )m_level[ 0 ] * 2 / 3, m_color[ 2 ] );
-        grad.addStep( m_level[ 0 ], m_color[ 0 ] );
-        grad.addStep( m_level[ 0 ] + 1, 0 );
-        grad.addStep( 255, 0 );
+        const Color::Gradient::Step steps[] = {
+            { 0, m_color[ 0 ] },
+            { uint8_t( m_level[ 0 ] / 3 ), m_color[ 1 ] },
+            { uint8_t( ( int )m_level[ 0 ] * 2 / 3 ), m_color[ 2 ] },
+            { m_level[ 0 ], m_color[ 0 ] },
+            { uint8_t( m_level[ 0 ] + 1 ), 0 },
+            { 255, 0 } };
+        m_gradient.setSteps( steps, std::size( steps ) );
     }
     else
     {
-        grad.addStep( 0, m_color[ 0 ] );
-        grad.addStep( 85, m_color[ 1 ] );
-        grad.addStep( 170, m_color[ 2 ] );
-        grad.addStep( 255, m_color[ 0 ] );
+        const Color::Gradient::Step steps[] = {
+            { 0, m_color[ 0 ] },
+            { 85, m_color[ 1 ] },
+            { 170, m_color[ 2 ] },
+            { 255, m_color[ 0 ] } };
+        m_gradient.setSteps( steps, std::size( steps ) );
     }
 }
 
-GradientPattern::~GradientPattern( )
-{
-    delete [] mp1;
-    mp1 = NULL;
-    delete [] mp2;
-    mp2 = NULL;
-}
-
 //-------------------------------------------------------------
 
 ms_t StrobePattern::GetDuration( Strip * )
 {
-    return 750; // 4Hz at 100% spped, 10Hz at 250% speed
+    return Duration;
 }
 
-void StrobePattern::Update( Strip *strip, ms_t offset )
+void StrobePattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    ms_t third( GetDuration( strip ) / 3 );
-    if ( ( offset / third ) != ( m_lastOffset / third ) )
+    // flash as each third starts
+    const int third = ( frame.phase * 3 ) >> 16;
+    if ( third != ( ( m_lastPhase * 3 ) >> 16 ) )
     {
-        strip->setAllColor( color( offset / third ) );
+        fill( pixels, color( third ) );
     }
     else
     {
-        strip->setAllColor( 0 );
+        fill( pixels, 0 );
     }
-    m_lastOffset = offset;
+    m_lastPhase = frame.phase;
 }
 
 //-------------------------------------------------------------
 
 ms_t CandyCanePattern::GetDuration( Strip * )
 {
-    return 200;
+    return Duration;
 }
 
-void CandyCanePattern::Update( Strip *strip, ms_t offset )
+void CandyCanePattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
     int c = 0;
-    if ( offset < ( GetDuration( strip ) / 2 ) )
+    if ( frame.phase < 0x8000 )
         c = 1;
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    const Color::rgb32_t colors[ 2 ] = { color( c ), color( c + 1 ) };
+    generate( pixels, [ & ]( size_t i )
     {
-        strip->setPixelColor( i, color( c + ( i % 2 ) ) );
-    }
+        return colors[ i & 1 ];
+    } );
 }
 
 //-------------------------------------------------------------
 
 ms_t TestPattern::GetDuration( Strip * )
 {
-    return 1000;
+    return Duration;
 }
 
-void TestPattern::Update( Strip *strip, ms_t )
+void TestPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& )
 {
+    if ( pixels.empty( ) )
+    {
+        return;
+    }
+
     switch ( m_level[0] >> 4 )
     {
     case 0:
@@ -429,41 +625,49 @@ void TestPattern::Update( Strip *strip, ms_t )
         // show value in level[1] as a count of LEDs
         const int code = m_level[1];
         const int space = 3;
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        int position = 0;
+        generate( pixels, [ & ]( size_t )
         {
-            bool on( ( i % ( code + space ) ) < code );
-            strip->setPixelColor( i, on ? m_color[ 0 ] : Color::rgb32_t::Black( ) );
-        }
+            bool on( position < code );
+            if ( ++position == code + space )
+            {
+                position = 0;
+            }
+            return on ? m_color[ 0 ] : Color::rgb32_t::Black( );
+        } );
         break;
     }
 
     case 1:
+    {
         // intensity scale
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        Ramp f( 255, pixels.size( ) );
+        generate( pixels, [ & ]( size_t )
         {
-            uint8_t f = i * 255 / strip->numPixels( );
-            strip->setPixelColor( i, Color::ColorFade( m_color[ 0 ], f ) );
-        }
+            return Color::ColorFade( m_color[ 0 ], f.next( ) );
+        } );
         break;
+    }
 
     case 2:
     {
-        // test gradient
-        Color::Gradient grad;
-        grad.clearSteps( );
-        grad.addStep( 0, m_color[ 0 ] );
-        grad.addStep( 85, m_color[ 1 ] );
-        grad.addStep( 170, m_color[ 2 ] );
-        grad.addStep( 255, m_color[ 0 ] );
-        for ( int i = 0; i < strip->numPixels( ); i++ )
+        // test gradient, only rebuilt when the colors change
+        const Color::Gradient::Step steps[] = {
+            { 0, m_color[ 0 ] },
+            { 85, m_color[ 1 ] },
+            { 170, m_color[ 2 ] },
+            { 255, m_color[ 0 ] } };
+        m_gradient.setSteps( steps, std::size( steps ) );
+        Ramp position( 255, pixels.size( ) );
+        generate( pixels, [ & ]( size_t )
         {
-            strip->setPixelColor( i, grad.getColor( i * 255 / strip->numPixels( ) ) );
-        }
+            return m_gradient.getColor( position.next( ) );
+        } );
         break;
     }
 
     default:
-        strip->setAllColor(Color::rgb32_t::Black());
+        fill( pixels, Color::rgb32_t::Black( ) );
     }
 }
 
@@ -471,17 +675,20 @@ void TestPattern::Update( Strip *strip, ms_t )
 
 ms_t FixedPattern::GetDuration( Strip * )
 {
-    return 750;
+    return Duration;
 }
 
-void FixedPattern::Update( Strip *strip, ms_t offset )
+void FixedPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
 {
-    int step = 3 * offset / GetDuration( strip );
-    auto col( color( step ) );
-    for ( int i = 0; i < strip->numPixels( ); i++ )
+    const int step = ( frame.phase * 3 ) >> 16;
+    const auto col( color( step ) );
+    int position = 0;
+    generate( pixels, [ & ]( size_t )
     {
-        strip->setPixelColor( i, ( i % 3 == step ) ? col : Color::rgb32_t::Black( ) );
-    }
+        bool on( position == step );
+        position = ( position == 2 ) ? 0 : ( position + 1 );
+        return on ? col : Color::rgb32_t::Black( );
+    } );
 }
 
 } // namespace Pattern
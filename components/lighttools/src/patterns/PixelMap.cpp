@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <math.h>
+#include "patterns/PixelMap.h"
+
+
+namespace Pattern
+{
+
+namespace
+{
+
+// position of index out of count along 0 - 255, the middle if there's only one
+uint8_t spread( uint32_t index, uint32_t count )
+{
+    return ( count > 1 ) ? ( index * 255 + ( count - 1 ) / 2 ) / ( count - 1 ) : 128;
+}
+
+} // namespace
+
+PixelMap PixelMap::Line( uint16_t count )
+{
+    PixelMap map;
+    map.m_points.resize( count );
+    for ( uint16_t i = 0; i < count; ++i )
+    {
+        map.m_points[ i ] = { spread( i, count ), 128, 0, 0 };
+    }
+    map.polar( );
+    return map;
+}
+
+PixelMap PixelMap::Matrix( uint16_t width, uint16_t height )
+{
+    PixelMap map;
+    map.m_points.resize( width * height );
+    for ( uint16_t row = 0; row < height; ++row )
+    {
+        for ( uint16_t column = 0; column < width; ++column )
+        {
+            map.m_points[ row * width + column ] = { spread( column, width ), spread( row, height ), 0, 0 };
+        }
+    }
+    map.polar( );
+    return map;
+}
+
+PixelMap PixelMap::Ring( uint16_t count )
+{
+    PixelMap map;
+    map.m_points.resize( count );
+    for ( uint16_t i = 0; i < count; ++i )
+    {
+        // y is down, so counterclockwise is towards -y
+        float angle = 2 * M_PI * i / count;
+        map.m_points[ i ] = { uint8_t( lroundf( 127.5f + 127.5f * cosf( angle ) ) ),
+            uint8_t( lroundf( 127.5f - 127.5f * sinf( angle ) ) ), uint8_t( i * 256 / count ), 255 };
+    }
+    return map;
+}
+
+PixelMap PixelMap::Positions( std::span< const std::array< uint8_t, 2 > > positions )
+{
+    PixelMap map;
+    map.m_points.resize( positions.size( ) );
+    for ( size_t i = 0; i < positions.size( ); ++i )
+    {
+        map.m_points[ i ] = { positions[ i ][ 0 ], positions[ i ][ 1 ], 0, 0 };
+    }
+    map.polar( );
+    return map;
+}
+
+std::vector< uint16_t > PixelMap::Serpentine( uint16_t width, uint16_t height )
+{
+    std::vector< uint16_t > order( width * height );
+    for ( uint16_t row = 0; row < height; ++row )
+    {
+        for ( uint16_t column = 0; column < width; ++column )
+        {
+            uint16_t shown = ( row & 1 ) ? ( width - 1 - column ) : column;
+            order[ row * width + column ] = row * width + shown;
+        }
+    }
+    return order;
+}
+
+void PixelMap::polar( )
+{
+    // around the middle of the layout, scaled to the furthest pixel
+    uint8_t left = 255, right = 0, top = 255, bottom = 0;
+    for ( const auto& point : m_points )
+    {
+        left = std::min( left, point[ X ] );
+        right = std::max( right, point[ X ] );
+        top = std::min( top, point[ Y ] );
+        bottom = std::max( bottom, point[ Y ] );
+    }
+    const float cx = ( left + right ) / 2.0f, cy = ( top + bottom ) / 2.0f;
+
+    float furthest = 0;
+    for ( const auto& point : m_points )
+    {
+        furthest = std::max( furthest, hypotf( point[ X ] - cx, point[ Y ] - cy ) );
+    }
+    for ( auto& point : m_points )
+    {
+        // y is down, so counterclockwise is towards -y
+        float dx = point[ X ] - cx, dy = cy - point[ Y ];
+        point[ Angle ] = uint8_t( lroundf( atan2f( dy, dx ) * 128 / float( M_PI ) ) & 255 );
+        point[ Radius ] = ( furthest > 0 ) ? uint8_t( lroundf( hypotf( dx, dy ) * 255 / furthest ) ) : 0;
+    }
+}
+
+} // namespace Pattern
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+#include "color/Frame.h"
 #include "patterns/Player.h"
 
 
@@ -10,96 +13,260 @@ void Player::UpdatePattern( ms_t now, const PlayerControl& control, Strip *strip
     strip->setBrightness( control.intensity );
 
     // update pattern
-    bool init( !m_pattern || control.pattern != m_patternId );
+    bool init( !m_current.pattern || control.pattern != m_patternId );
     if ( init )
     {
-        delete m_pattern;
-        m_patternId = control.pattern;
-        m_pattern = CreatePattern( m_patternId );
-    }
-
-    // update speed
-    // --> I suspect there are bugs here .. 
-    // --> should probably track m_count (cycle count) and m_update (last update timestamp)
-    if ( !init && m_speed != control.speed )
-    {
-        // adjust start and offset to match new speed
-        ms_t duration( m_pattern->GetDuration( strip ) );
-        ms_t elapsed = ( ( now - m_start ) * m_speed / 100 );
-        if ( control.speed == 0 )
+        advance( now );
+        if ( control.transition && m_current.pattern )
         {
-            // speed dropped to zero, set offset to where we are right now
-            m_offset = elapsed % duration;
+            startTransition( now, control.transition * 10, strip );
         }
-        else if ( m_speed == 0 )
+        else
         {
-            // speed coming up off zero, set start so count and offset stay stable
-            // --> if count is large then this could go negative .. 
-            // --> don't track this way, see above
-            m_start = now - ( m_count * duration ) * 100 / control.speed - m_offset;
+            // cut, dropping any pattern still fading out
+            m_outgoing = Track( );
         }
-        else
+
+        // each pattern slot has half the scratch memory
+        const size_t scratch( strip->numPixels( ) * Pattern::ScratchPerPixel );
+        if ( m_scratch.size( ) < scratch * m_storage.size( ) )
         {
-            // solve for new start time so the elapsed time (and thus offset
-            // and cycle count) stay the same
-            m_start = now - ( elapsed * 100 / control.speed );
+            m_scratch.resize( scratch * m_storage.size( ) );
         }
 
-        // and store the new speed
+        m_slot = ( m_slot + 1 ) % m_storage.size( );
+        m_patternId = control.pattern;
+        m_current = Track( );
+        m_current.pattern = CreatePattern( m_patternId, m_storage[ m_slot ] );
+        m_current.duration = std::max< ms_t >( m_current.pattern->GetDuration( strip ), 1 );
+        m_current.pattern->setScratch( std::span( m_scratch ).subspan( scratch * m_slot, scratch ) );
+
+        // strips that don't keep their pixels are rendered through a copy
+        if ( strip->pixels( ).empty( ) && m_stripPixels.size( ) != strip->numPixels( ) )
+        {
+            m_stripPixels.resize( strip->numPixels( ) );
+        }
+        m_current.pattern->setStripPixels( m_stripPixels );
+    }
+
+    // update speed, carrying on from the current position
+    if ( init || m_speed != control.speed )
+    {
+        advance( now );
         m_speed = control.speed;
+
+        // round up, so the pattern reaches each point no later than it would by the clock
+        uint64_t scale = 100 * m_current.duration;
+        m_current.step = ( ( ( uint64_t )m_speed << 32 ) + scale - 1 ) / scale;
     }
 
     // update colors
     for ( int i = 0; i < 3; ++i )
     {
         auto c( control.color[ i ] );
-        m_pattern->setColor( i, Color::rgb32_t( c.r, c.g, c.b ) );
+        m_current.pattern->setColor( i, Color::rgb32_t( c.r, c.g, c.b ) );
     }
 
     // update levels
     for ( int i = 0; i < 3; ++i )
     {
-        m_pattern->setLevel( i, control.level[ i ] );
+        m_current.pattern->setLevel( i, control.level[ i ] );
+    }
+    m_current.pattern->setSeed( control.seed );
+    m_current.pattern->setPixelMap( strip->pixelMap( ) );
+
+    // cached frames are stale if the look changed
+    if ( init || std::memcmp( control.color, m_cacheControl.color, sizeof( control.color ) )
+        || std::memcmp( control.level, m_cacheControl.level, sizeof( control.level ) ) )
+    {
+        m_cacheControl = control;
+        resetCache( strip );
     }
 
     // init the pattern if needed
     if ( init )
     {
-        m_pattern->Init( strip, 0 );
-        m_start = now;
-        m_offset = 0;
-        m_count = 0;
-        m_speed = control.speed;
+        bool looped;
+        if ( m_outgoing.pattern )
+        {
+            // the incoming pattern starts from black in its own buffer
+            std::fill( m_currentPixels.begin( ), m_currentPixels.end( ), Color::rgb32_t::Black( ) );
+            m_current.pattern->RenderInit( m_currentPixels, m_current.frame( looped ) );
+        }
+        else
+        {
+            m_current.pattern->Init( strip, m_current.frame( looped ) );
+        }
     }
 }
 
 void Player::UpdateStrip( ms_t now, Strip *strip )
 {
     // update the strip if it's time
-    if ( m_pattern && strip )
+    if ( m_current.pattern && strip )
+    {
+        advance( now );
+        if ( m_outgoing.pattern )
+        {
+            updateTransition( now, strip );
+            return;
+        }
+
+        if ( m_cacheFrames )
+        {
+            updateCached( strip );
+            return;
+        }
+
+        bool looped;
+        auto frame( m_current.frame( looped ) );
+        if ( looped )
+        {
+            m_current.pattern->Loop( strip, frame );
+        }
+        else
+        {
+            m_current.pattern->Update( strip, frame );
+        }
+    }
+}
+
+void Player::setLoopCache( ms_t resolution, size_t maxBytes )
+{
+    m_cacheResolution = resolution;
+    m_cacheBytes = maxBytes;
+    m_cacheFrames = 0;
+}
+
+void Player::resetCache( Strip *strip )
+{
+    m_cacheFrames = 0;
+    if ( !m_cacheResolution || !m_current.pattern->cacheable( ) )
+    {
+        return;
+    }
+
+    const size_t count = strip->numPixels( );
+    uint32_t frames = std::max< uint32_t >( m_current.duration / m_cacheResolution, 1 );
+    if ( !count || frames * count * sizeof( Color::rgb32_t ) > m_cacheBytes )
     {
-        if ( m_speed == 0 )
+        return;
+    }
+    if ( m_cache.size( ) < frames * count )
+    {
+        m_cache.resize( frames * count );
+    }
+    m_cached.assign( frames, false );
+    m_cacheFrames = frames;
+    m_cachePixels = count;
+}
+
+void Player::updateCached( Strip *strip )
+{
+    // the frame for this step of the phase
+    const size_t count = strip->numPixels( );
+    if ( count != m_cachePixels )
+    {
+        resetCache( strip );
+        if ( !m_cacheFrames )
         {
-            // stopped at the previous offset
-            m_pattern->Update( strip, m_offset );
+            UpdateStrip( m_last, strip );
+            return;
+        }
+    }
+    bool looped;
+    auto frame( m_current.frame( looped ) );
+    uint32_t step = ( frame.phase * m_cacheFrames ) >> 16;
+    std::span< Color::rgb32_t > pixels( m_cache.data( ) + step * count, count );
+
+    // rendered at the start of the step the first time it comes up
+    if ( !m_cached[ step ] )
+    {
+        Frame start;
+        start.phase = ( ( step << 16 ) + m_cacheFrames - 1 ) / m_cacheFrames;
+        start.offset = ( ( uint32_t )start.phase * m_current.duration ) >> 16;
+        start.loop = frame.loop;
+        m_current.pattern->Render( pixels, start );
+        m_cached[ step ] = true;
+    }
+    strip->writePixels( pixels );
+}
+
+void Player::startTransition( ms_t now, ms_t duration, Strip *strip )
+{
+    const size_t count = strip->numPixels( );
+    m_outgoingPixels.resize( count );
+    m_currentPixels.resize( count );
+    m_framePixels.resize( count );
+    if ( m_outgoing.pattern )
+    {
+        // already crossfading, the incoming pattern has its frame in its buffer
+        // and the oldest pattern is dropped
+        std::swap( m_outgoingPixels, m_currentPixels );
+    }
+    else
+    {
+        // the outgoing pattern carries on from what's on the strip
+        for ( size_t i = 0; i < count; ++i )
+        {
+            m_outgoingPixels[ i ] = strip->getPixelColor( i );
+        }
+    }
+    m_outgoing = m_current;
+    m_transitionStart = now;
+    m_transitionTime = duration;
+}
+
+void Player::updateTransition( ms_t now, Strip *strip )
+{
+    // render both patterns into their buffers
+    for ( auto track : { std::make_pair( &m_outgoing, &m_outgoingPixels ), std::make_pair( &m_current, &m_currentPixels ) } )
+    {
+        bool looped;
+        auto frame( track.first->frame( looped ) );
+        if ( looped )
+        {
+            track.first->pattern->RenderLoop( *track.second, frame );
         }
         else
         {
-            ms_t duration( m_pattern->GetDuration( strip ) );
-            ms_t elapsed = ( ( now - m_start ) * m_speed / 100 );
-            m_offset = elapsed % duration;
-            unsigned long count = elapsed / duration;
-            if ( count != m_count )
-            {
-                m_count = count;
-                m_pattern->Loop( strip, m_offset );
-            }
-            else
-            {
-                m_pattern->Update( strip, m_offset );
-            }
+            track.first->pattern->Render( *track.second, frame );
         }
     }
+
+    ms_t elapsed = now - m_transitionStart;
+    if ( elapsed >= m_transitionTime )
+    {
+        // done, the current pattern carries on from its frame on the strip
+        strip->writePixels( m_currentPixels );
+        m_outgoing = Track( );
+        return;
+    }
+
+    // crossfade, leaving each pattern's own frame for it to carry on from
+    uint16_t alpha = elapsed * 256 / m_transitionTime;
+    std::copy( m_outgoingPixels.begin( ), m_outgoingPixels.end( ), m_framePixels.begin( ) );
+    Color::OverFrame( m_framePixels, m_currentPixels, alpha );
+    strip->writePixels( m_framePixels );
+}
+
+void Player::advance( ms_t now )
+{
+    ms_t elapsed = now - m_last;
+    m_current.position += ( uint64_t )elapsed * m_current.step;
+    m_outgoing.position += ( uint64_t )elapsed * m_outgoing.step;
+    m_last = now;
+}
+
+Frame Player::Track::frame( bool& looped )
+{
+    Frame current;
+    current.loop = position >> 32;
+    current.phase = position >> 16;
+    current.offset = ( ( uint32_t )current.phase * duration ) >> 16;
+    looped = ( current.loop != loop );
+    loop = current.loop;
+    return current;
 }
 
 } // namespace Pattern
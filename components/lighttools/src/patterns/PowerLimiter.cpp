@@ -0,0 +1,59 @@
+#include <algorithm>
+#include "patterns/PowerLimiter.h"
+
+
+namespace Pattern
+{
+
+void PowerLimiter::setBudget( uint32_t milliamps )
+{
+    m_budget = milliamps;
+    if ( !m_budget )
+    {
+        m_scale = m_allowed = Unity;
+    }
+}
+
+void PowerLimiter::setModel( uint32_t channelMicroamps, uint32_t idleMicroamps )
+{
+    m_channel = channelMicroamps;
+    m_idle = idleMicroamps;
+}
+
+uint32_t PowerLimiter::estimate( uint32_t levels, size_t pixels ) const
+{
+    return ( ( uint64_t )levels * m_channel / 255 + ( uint64_t )pixels * m_idle ) / 1000;
+}
+
+uint16_t PowerLimiter::update( uint32_t levels, size_t pixels )
+{
+    if ( !m_budget )
+    {
+        m_current = estimate( levels, pixels );
+        return Unity;
+    }
+
+    // the largest scale that keeps the frame in budget, the quiescent current
+    // is drawn regardless
+    uint64_t idle = ( uint64_t )pixels * m_idle;
+    uint64_t available = ( uint64_t )m_budget * 1000;
+    available = ( available > idle ) ? ( available - idle ) : 0;
+    uint64_t demand = ( uint64_t )levels * m_channel / 255;
+    m_allowed = demand ? std::min< uint64_t >( Unity, available * Unity / demand ) : Unity;
+
+    // drop at once, recover gradually
+    uint16_t sent = std::min( m_scale, m_allowed );
+    if ( m_allowed < m_scale )
+    {
+        m_scale = m_allowed;
+    }
+    else if ( m_allowed > m_scale )
+    {
+        m_scale += std::max( 1, ( m_allowed - m_scale ) >> RecoveryShift );
+    }
+
+    m_current = ( demand * sent / Unity + idle ) / 1000;
+    return sent;
+}
+
+} // namespace Pattern
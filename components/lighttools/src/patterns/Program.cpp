@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cstring>
+#include "patterns/Pattern.h"
+#include "patterns/Program.h"
+
+
+namespace Pattern
+{
+
+namespace
+{
+
+// true if an instruction only uses registers that exist, and only jumps forward within the program
+bool valid( const Instruction& instruction, size_t pc, size_t count )
+{
+    const uint8_t r = Program::Registers;
+    switch ( instruction.op )
+    {
+    case Op::End:
+        return true;
+    case Op::Load:
+        return instruction.d < r;
+    case Op::AddImm:
+        return instruction.d < r && instruction.a < r;
+    case Op::Pack:
+        return instruction.d < r - 2;
+    case Op::Unpack:
+        return instruction.d < r - 2 && instruction.a < r;
+    case Op::Jump:
+        return instruction.b > pc && instruction.b <= count;
+    case Op::JumpZero:
+    case Op::JumpNotZero:
+        return instruction.a < r && instruction.b > pc && instruction.b <= count;
+    default:
+        return instruction.op < Op::Count && instruction.d < r && instruction.a < r && instruction.b < r;
+    }
+}
+
+inline Color::rgb32_t packedColor( int32_t value )
+{
+    Color::rgb32_t color;
+    color.packed = value & 0xffffff;
+    return color;
+}
+
+inline uint8_t channel( int32_t value )
+{
+    return std::clamp< int32_t >( value, 0, 255 );
+}
+
+} // namespace
+
+bool Program::load( std::span< const uint8_t > bytes )
+{
+    if ( bytes.size( ) < HeaderSize || bytes[ 0 ] != 'R' || bytes[ 1 ] != 'P' || bytes[ 2 ] != Version )
+    {
+        return false;
+    }
+    size_t count = bytes[ 3 ];
+    uint16_t duration = bytes[ 4 ] | ( bytes[ 5 ] << 8 );
+    if ( count > MaxInstructions || bytes.size( ) != HeaderSize + count * sizeof( Instruction ) || !duration )
+    {
+        return false;
+    }
+
+    // check it all before replacing the current program
+    auto code( reinterpret_cast< const Instruction * >( bytes.data( ) + HeaderSize ) );
+    for ( size_t pc = 0; pc < count; ++pc )
+    {
+        if ( !valid( code[ pc ], pc, count ) )
+        {
+            return false;
+        }
+    }
+    std::copy( code, code + count, m_code.begin( ) );
+    m_count = count;
+    m_duration = duration;
+    return true;
+}
+
+size_t Program::encode( uint16_t duration, std::span< const Instruction > code, std::span< uint8_t > bytes )
+{
+    size_t size = HeaderSize + code.size( ) * sizeof( Instruction );
+    if ( code.size( ) > MaxInstructions || bytes.size( ) < size )
+    {
+        return 0;
+    }
+    const uint8_t header[ HeaderSize ] = { 'R', 'P', Version, uint8_t( code.size( ) ), uint8_t( duration ), uint8_t( duration >> 8 ) };
+    std::copy( header, header + HeaderSize, bytes.begin( ) );
+    std::memcpy( bytes.data( ) + HeaderSize, code.data( ), code.size( ) * sizeof( Instruction ) );
+    return size;
+}
+
+//-------------------------------------------------------------
+
+size_t ProgramStore::split( std::span< const uint8_t > bytes, uint8_t slot, uint8_t id, std::span< ProgramChunk > chunks )
+{
+    size_t count = ( bytes.size( ) + ProgramChunk::DataSize - 1 ) / ProgramChunk::DataSize;
+    if ( bytes.empty( ) || bytes.size( ) > Program::MaxSize || count > chunks.size( ) )
+    {
+        return 0;
+    }
+    for ( size_t index = 0; index < count; ++index )
+    {
+        auto data( bytes.subspan( index * ProgramChunk::DataSize ) );
+        data = data.first( std::min( data.size( ), ProgramChunk::DataSize ) );
+
+        auto& chunk( chunks[ index ] );
+        chunk.slot = slot;
+        chunk.id = id;
+        chunk.index = index;
+        chunk.count = count;
+        chunk.length = data.size( );
+        std::copy( data.begin( ), data.end( ), chunk.data );
+    }
+    return count;
+}
+
+bool ProgramStore::receive( const ProgramChunk& chunk )
+{
+    if ( chunk.slot >= Slots || !chunk.count || chunk.count > MaxChunks || chunk.index >= chunk.count
+        || chunk.length > ProgramChunk::DataSize
+        || ( chunk.index + 1 < chunk.count && chunk.length != ProgramChunk::DataSize ) )
+    {
+        return false;
+    }
+
+    // chunks come in order, the first starts a transfer and each one after
+    // has to be the next of the same program, anything else drops it
+    auto& transfer( m_transfers[ chunk.slot ] );
+    if ( chunk.index == 0 )
+    {
+        transfer.id = chunk.id;
+        transfer.count = chunk.count;
+        transfer.received = 0;
+    }
+    else if ( !transfer.count || transfer.id != chunk.id || transfer.count != chunk.count
+        || transfer.received != chunk.index )
+    {
+        transfer.count = 0;
+        return false;
+    }
+
+    std::copy( chunk.data, chunk.data + chunk.length, transfer.bytes.begin( ) + chunk.index * ProgramChunk::DataSize );
+    transfer.received = chunk.index + 1;
+    if ( transfer.received != transfer.count )
+    {
+        return false;
+    }
+
+    // complete, chunks sent again after this start a new transfer
+    transfer.count = 0;
+    const size_t size = chunk.index * ProgramChunk::DataSize + chunk.length;
+    return m_programs[ chunk.slot ].load( std::span< const uint8_t >( transfer.bytes ).first( size ) );
+}
+
+ProgramStore& Programs( )
+{
+    static ProgramStore programs;
+    return programs;
+}
+
+//-------------------------------------------------------------
+
+std::span< const ExampleProgram > ExamplePrograms( )
+{
+    // a wave of color 0 over color 1 moving along the strip, level 0 is the number of waves
+    static const Instruction ripple[] =
+    {
+        { Op::Mul, 8, 0, 4 },           // r8 = index * level 0 >> 3
+        { Op::Load, 9, 3, 0 },
+        { Op::Shr, 8, 8, 9 },
+        { Op::Load, 9, 8, 0 },          // less phase >> 8
+        { Op::Shr, 10, 2, 9 },
+        { Op::Sub, 8, 8, 10 },
+        { Op::Triangle, 7, 8, 0 },      // blend by the wave
+        { Op::Load, 11, 0, 0 },
+        { Op::Color, 12, 11, 0 },
+        { Op::AddImm, 11, 11, 1 },
+        { Op::Color, 13, 11, 0 },
+        { Op::Blend, 7, 13, 12 },
+    };
+
+    // random pixels in the colors each loop, fading out over the loop, level 0 is how many
+    static const Instruction fireflies[] =
+    {
+        { Op::Random, 8, 0, 0 },        // lit if random < level 0 * 64
+        { Op::Load, 9, 64, 0 },
+        { Op::Mul, 9, 4, 9 },
+        { Op::Less, 10, 8, 9 },
+        { Op::Load, 7, 0, 0 },
+        { Op::JumpZero, 0, 10, 12 },
+        { Op::Color, 11, 8, 0 },        // in a random color
+        { Op::Load, 9, 8, 0 },          // at 255 - phase >> 8
+        { Op::Shr, 12, 2, 9 },
+        { Op::Load, 13, 255, 0 },
+        { Op::Sub, 12, 13, 12 },
+        { Op::Fade, 7, 11, 12 },
+    };
+
+    // a pixel of color 0 running along the strip, leaving a trail faded by level 0 each frame
+    static const Instruction comet[] =
+    {
+        { Op::Mul, 8, 2, 1 },           // head at phase * count >> 16
+        { Op::Load, 9, 16, 0 },
+        { Op::Shr, 8, 8, 9 },
+        { Op::Equal, 10, 8, 0 },
+        { Op::JumpZero, 0, 10, 8 },
+        { Op::Load, 11, 0, 0 },
+        { Op::Color, 7, 11, 0 },
+        { Op::End, 0, 0, 0 },
+        { Op::Fade, 7, 7, 4 },
+    };
+
+    static const ExampleProgram examples[] =
+    {
+        { "ripple", 2000, ripple },
+        { "fireflies", 1000, fireflies },
+        { "comet", 1500, comet },
+    };
+    return examples;
+}
+
+//-------------------------------------------------------------
+
+ms_t ProgramPattern::GetDuration( Strip * )
+{
+    return Programs( ).program( m_slot ).duration( );
+}
+
+void ProgramPattern::Render( std::span< Color::rgb32_t > pixels, const Frame& frame )
+{
+    const auto code( Programs( ).program( m_slot ).code( ) );
+    if ( code.empty( ) )
+    {
+        fill( pixels, Color::rgb32_t::Black( ) );
+        return;
+    }
+
+    const auto rand( random( frame.loop ) );
+    int32_t r[ Program::Registers ] = { };
+    generate( pixels, [ & ]( size_t i )
+    {
+        r[ 0 ] = i;
+        r[ 1 ] = pixels.size( );
+        r[ 2 ] = frame.phase;
+        r[ 3 ] = frame.loop;
+        r[ 4 ] = m_level[ 0 ];
+        r[ 5 ] = m_level[ 1 ];
+        r[ 6 ] = m_level[ 2 ];
+        r[ 7 ] = pixels[ i ].packed & 0xffffff;
+
+        // arithmetic wraps, as unsigned
+        const Instruction *begin = code.data( ), *end = begin + code.size( );
+        for ( const Instruction *ip = begin; ip < end; ++ip )
+        {
+            const uint8_t d = ip->d, a = ip->a, b = ip->b;
+            switch ( ip->op )
+            {
+            case Op::End: ip = end - 1; break;
+            case Op::Load: r[ d ] = int16_t( a | ( b << 8 ) ); break;
+            case Op::Move: r[ d ] = r[ a ]; break;
+            case Op::Add: r[ d ] = uint32_t( r[ a ] ) + uint32_t( r[ b ] ); break;
+            case Op::AddImm: r[ d ] = uint32_t( r[ a ] ) + uint32_t( int8_t( b ) ); break;
+            case Op::Sub: r[ d ] = uint32_t( r[ a ] ) - uint32_t( r[ b ] ); break;
+            case Op::Mul: r[ d ] = uint32_t( r[ a ] ) * uint32_t( r[ b ] ); break;
+            case Op::Scale: r[ d ] = ( int64_t( r[ a ] ) * r[ b ] ) >> 8; break;
+            case Op::Div: r[ d ] = ( r[ b ] == 0 ) ? 0 : ( r[ b ] == -1 ) ? -uint32_t( r[ a ] ) : r[ a ] / r[ b ]; break;
+            case Op::Mod: r[ d ] = ( r[ b ] == 0 || r[ b ] == -1 ) ? 0 : r[ a ] % r[ b ]; break;
+            case Op::And: r[ d ] = r[ a ] & r[ b ]; break;
+            case Op::Or: r[ d ] = r[ a ] | r[ b ]; break;
+            case Op::Xor: r[ d ] = r[ a ] ^ r[ b ]; break;
+            case Op::Shl: r[ d ] = uint32_t( r[ a ] ) << ( r[ b ] & 31 ); break;
+            case Op::Shr: r[ d ] = r[ a ] >> ( r[ b ] & 31 ); break;
+            case Op::Min: r[ d ] = std::min( r[ a ], r[ b ] ); break;
+            case Op::Max: r[ d ] = std::max( r[ a ], r[ b ] ); break;
+            case Op::Less: r[ d ] = r[ a ] < r[ b ]; break;
+            case Op::Equal: r[ d ] = r[ a ] == r[ b ]; break;
+            case Op::Triangle:
+            {
+                int32_t t = r[ a ] & 255;
+                r[ d ] = ( t < 128 ) ? ( t * 2 ) : ( 511 - t * 2 );
+                break;
+            }
+            case Op::Random: r[ d ] = rand( r[ a ] ) >> 16; break;
+            case Op::Color: r[ d ] = m_color[ uint32_t( r[ a ] ) % 3 ].packed & 0xffffff; break;
+            case Op::Wheel: r[ d ] = Color::ColorWheel( r[ a ] & 255 ).packed; break;
+            case Op::Fade: r[ d ] = Color::ColorFade( packedColor( r[ a ] ), channel( r[ b ] ) ).packed; break;
+            case Op::Blend: r[ d ] = Color::ColorBlend( packedColor( r[ a ] ), packedColor( r[ b ] ), channel( r[ d ] ) ).packed; break;
+            case Op::Pack: r[ d ] = Color::rgb32_t( channel( r[ d ] ), channel( r[ d + 1 ] ), channel( r[ d + 2 ] ) ).packed; break;
+            case Op::Unpack:
+            {
+                auto c( packedColor( r[ a ] ) );
+                r[ d ] = c.r( );
+                r[ d + 1 ] = c.g( );
+                r[ d + 2 ] = c.b( );
+                break;
+            }
+            case Op::Jump: ip = begin + b - 1; break;
+            case Op::JumpZero: ip = r[ a ] ? ip : ( begin + b - 1 ); break;
+            case Op::JumpNotZero: ip = r[ a ] ? ( begin + b - 1 ) : ip; break;
+            default: break;
+            }
+        }
+        return packedColor( r[ 7 ] );
+    } );
+}
+
+} // namespace Pattern
@@ -1,4 +1,3 @@
-#include <cstdlib> // rand
 #include "patterns/Pattern.h"
 #include "patterns/Sequence.h"
 
@@ -35,22 +34,23 @@ const std::span<Step> alertSteps()
 
 const std::span<Step> randomSteps()
 {
-    static std::array<Step, 14> steps
+    static std::array<Step, 15> steps
     {{
-        { 30000, { FULL, MiniTwinkle, 160, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Yellow(), 160 } }, // rwy twinkle
-        { 30000, { FULL, MiniTwinkle, 160, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 160 } }, // rwg twinkle
-        { 30000, { FULL, Gradient,     35, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Red(), 17 } }, // rwr subtle
-        { 30000, { FULL, Gradient,     75, Color::rgb24_t::Blue(), Color::rgb24_t{ 128, 128, 255 }, Color::rgb24_t::Blue(), 75 } }, // blue smooth
-        { 30000, { FULL, MiniTwinkle, 160, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Blue(), 160 } }, // rwb
-        { 30000, { HALF, CandyCane,    65, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 255 } }, // rwg candy
-        { 30000, { HALF, CandyCane,   100, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Red(), 255 } }, // rwr candy
-        { 30000, { FULL, Fixed,       100, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 255 } }, // rwg tree
-        { 30000, { FULL, March,       127, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 8 } }, // rwg march
-        { 30000, { FULL, Wipe,        127, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 8 } }, // rwg wipe
-        { 30000, { FULL, MiniSparkle, 255, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 9 } }, // rwg flicker
-        { 30000, { FULL, MiniTwinkle, 100, Color::rgb24_t::Cyan(), Color::rgb24_t::Magenta(), Color::rgb24_t::Yellow(), 128 } }, // cga
-        { 30000, { HALF, Rainbow,     100, Color::rgb24_t::White(), Color::rgb24_t::White(), Color::rgb24_t::White(), 255 } }, //  rainbow
-        { 30000, { HALF, Strobe,      128, Color::rgb24_t::White(), Color::rgb24_t::White(), Color::rgb24_t::White(), 255 } } // strobe
+        { 30000, { FULL, MiniTwinkle, 160, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Yellow(), 160, 0, 0, 100 } }, // rwy twinkle
+        { 30000, { FULL, MiniTwinkle, 160, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 160, 0, 0, 100 } }, // rwg twinkle
+        { 30000, { FULL, Gradient,     35, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Red(), 17, 0, 0, 100 } }, // rwr subtle
+        { 30000, { FULL, Gradient,     75, Color::rgb24_t::Blue(), Color::rgb24_t{ 128, 128, 255 }, Color::rgb24_t::Blue(), 75, 0, 0, 100 } }, // blue smooth
+        { 30000, { FULL, MiniTwinkle, 160, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Blue(), 160, 0, 0, 100 } }, // rwb
+        { 30000, { HALF, CandyCane,    65, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 255, 0, 0, 100 } }, // rwg candy
+        { 30000, { HALF, CandyCane,   100, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Red(), 255, 0, 0, 100 } }, // rwr candy
+        { 30000, { FULL, Fixed,       100, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 255, 0, 0, 100 } }, // rwg tree
+        { 30000, { FULL, March,       127, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 8, 0, 0, 100 } }, // rwg march
+        { 30000, { FULL, Wipe,        127, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 8, 0, 0, 100 } }, // rwg wipe
+        { 30000, { FULL, MiniSparkle, 255, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 9, 0, 0, 100 } }, // rwg flicker
+        { 30000, { FULL, MiniTwinkle, 100, Color::rgb24_t::Cyan(), Color::rgb24_t::Magenta(), Color::rgb24_t::Yellow(), 128, 0, 0, 100 } }, // cga
+        { 30000, { HALF, Rainbow,     100, Color::rgb24_t::White(), Color::rgb24_t::White(), Color::rgb24_t::White(), 255, 0, 0, 100 } }, //  rainbow
+        { 30000, { FULL, Bytecode,    100, Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green(), 64, 0, 0, 100 } }, // rwg ripple, program sent by the controller
+        { 30000, { HALF, Strobe,      128, Color::rgb24_t::White(), Color::rgb24_t::White(), Color::rgb24_t::White(), 255, 0, 0, 100 } } // strobe
     }};
     return std::span<Step>(steps);
 }
@@ -84,7 +84,7 @@ int Sequence::Advance( int step, [[maybe_unused]] bool timed )
 
 int RandomSequence::Reset( )
 {
-    return std::rand( ) % ( GetStepCount( ) - 1 );
+    return m_random.below( m_draws++, GetStepCount( ) - 1 );
 }
 
 int RandomSequence::Advance( [[maybe_unused]] int step, bool timed )
@@ -6,12 +6,43 @@ namespace Pattern
 
 void Strip::setAllColor( Color::rgb32_t color)
 {
-    for ( uint16_t i = 0; i < numPixels( ); i++ ) 
+    fillRange( 0, numPixels( ), color );
+}
+
+void Strip::fillRange( uint16_t first, uint16_t count, Color::rgb32_t color )
+{
+    for ( uint16_t i = first; i < first + count; i++ )
     {
         setPixelColor( i, color );
     }
 }
 
+void Strip::copyRange( uint16_t dst, uint16_t src, uint16_t count )
+{
+    if ( dst < src )
+    {
+        for ( uint16_t i = 0; i < count; i++ )
+        {
+            setPixelColor( dst + i, getPixelColor( src + i ) );
+        }
+    }
+    else
+    {
+        for ( uint16_t i = count; i > 0; i-- )
+        {
+            setPixelColor( dst + i - 1, getPixelColor( src + i - 1 ) );
+        }
+    }
+}
+
+void Strip::writePixels( std::span< const Color::rgb32_t > colors, uint16_t first )
+{
+    for ( const auto& color : colors )
+    {
+        setPixelColor( first++, color );
+    }
+}
+
 /*
 void Strip::setAllFade( uint8_t v )
 {
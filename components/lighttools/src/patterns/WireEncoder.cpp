@@ -0,0 +1,233 @@
+#include <math.h>
+#include "patterns/WireEncoder.h"
+
+
+namespace Pattern
+{
+
+WireEncoder::WireEncoder( WireFormat format )
+    : m_brightness( 255 ), m_gamma( 1.0f ), m_whiteBalance( Color::rgb32_t::White( ) ), m_dither( false ),
+      m_format( format )
+{
+    rebuild( );
+}
+
+void WireEncoder::setBrightness( uint8_t bright )
+{
+    if ( bright != m_brightness )
+    {
+        m_brightness = bright;
+        rebuild( );
+    }
+}
+
+void WireEncoder::setGamma( float gamma )
+{
+    if ( gamma != m_gamma )
+    {
+        m_gamma = gamma;
+        rebuild( );
+    }
+}
+
+void WireEncoder::setWhiteBalance( Color::rgb32_t gains )
+{
+    if ( gains != m_whiteBalance )
+    {
+        m_whiteBalance = gains;
+        rebuild( );
+    }
+}
+
+void WireEncoder::setDither( bool dither )
+{
+    if ( dither != m_dither )
+    {
+        m_dither = dither;
+        rebuild( );
+    }
+}
+
+uint8_t WireEncoder::correct( uint8_t value, uint8_t gain ) const
+{
+    if ( m_gamma == 1.0f )
+    {
+        // keep linear output exact
+        return ( uint32_t )value * m_brightness * gain / ( 255 * 255 );
+    }
+    float level = powf( value / 255.0f, m_gamma ) * 255.0f;
+    return level * m_brightness * gain / ( 255.0f * 255.0f ) + 0.5f;
+}
+
+uint16_t WireEncoder::correct16( uint8_t value, uint8_t gain ) const
+{
+    // top out at 0xff00 so adding a carried fraction can't overflow 8 bits
+    if ( m_gamma == 1.0f )
+    {
+        return ( uint64_t )value * m_brightness * gain * 256 / ( 255 * 255 );
+    }
+    float level = powf( value / 255.0f, m_gamma ) * 255.0f;
+    return level * m_brightness * gain * 256.0f / ( 255.0f * 255.0f ) + 0.5f;
+}
+
+void WireEncoder::rebuild( )
+{
+    // white balance only applies to RGB, white is always unity
+    const uint8_t gains[ MaxPixelSize ] = { m_whiteBalance.g( ), m_whiteBalance.r( ), m_whiteBalance.b( ), 255 };
+    for ( size_t channel = 0; channel < pixelSize( ); ++channel )
+    {
+        for ( uint32_t v = 0; v < m_lut[ channel ].size( ); ++v )
+        {
+            m_lut[ channel ][ v ] = correct( v, gains[ channel ] );
+            if ( m_dither )
+            {
+                m_lut16[ channel ][ v ] = correct16( v, gains[ channel ] );
+            }
+        }
+    }
+}
+
+template< WireFormat Format, bool Dither, bool Limit >
+uint32_t WireEncoder::encodePixels( std::span< const Color::rgb32_t > pixels, uint8_t *residual, uint8_t *out,
+    uint16_t scale ) const
+{
+    constexpr size_t size = ( Format == WireFormat::GRBW ) ? 4 : 3;
+    uint32_t levels = 0;
+    for ( const auto& pixel : pixels )
+    {
+        // channel values in wire order
+        uint32_t packed;
+        if constexpr ( Format == WireFormat::GRBW )
+        {
+            packed = m_white.extract( pixel ).packed;
+        }
+        else
+        {
+            packed = pixel.packed;
+        }
+        const uint8_t values[ MaxPixelSize ] = { uint8_t( packed >> 8 ), uint8_t( packed >> 16 ),
+            uint8_t( packed ), uint8_t( packed >> 24 ) };
+
+        for ( size_t channel = 0; channel < size; ++channel )
+        {
+            if constexpr ( Dither )
+            {
+                uint32_t v = m_lut16[ channel ][ values[ channel ] ];
+                if constexpr ( Limit )
+                {
+                    levels += v;
+                    v = ( v * scale ) >> 8;
+                }
+                v += residual[ channel ];
+                out[ channel ] = v >> 8;
+                residual[ channel ] = v;
+            }
+            else
+            {
+                uint32_t v = m_lut[ channel ][ values[ channel ] ];
+                if constexpr ( Limit )
+                {
+                    levels += v;
+                    v = ( v * scale ) >> 8;
+                }
+                out[ channel ] = v;
+            }
+        }
+        out += size;
+        if constexpr ( Dither )
+        {
+            residual += size;
+        }
+    }
+    return levels;
+}
+
+template< bool Dither >
+void WireEncoder::encodeFrame( std::span< const Color::rgb32_t > pixels, uint8_t *residual, uint8_t *out )
+{
+    // gather into wire order, then encode as usual
+    if ( !m_order.empty( ) && m_order.size( ) == pixels.size( ) )
+    {
+        m_ordered.resize( pixels.size( ) );
+        for ( size_t i = 0; i < m_order.size( ); ++i )
+        {
+            m_ordered[ i ] = pixels[ m_order[ i ] ];
+        }
+        pixels = m_ordered;
+    }
+
+    if ( !m_limiter.budget( ) )
+    {
+        if ( m_format == WireFormat::GRBW )
+        {
+            encodePixels< WireFormat::GRBW, Dither, false >( pixels, residual, out, PowerLimiter::Unity );
+        }
+        else
+        {
+            encodePixels< WireFormat::GRB, Dither, false >( pixels, residual, out, PowerLimiter::Unity );
+        }
+        return;
+    }
+
+    // encode at the last frame's scale, summing the levels as we go
+    uint16_t scale = m_limiter.scale( );
+    uint32_t levels;
+    if ( m_format == WireFormat::GRBW )
+    {
+        levels = encodePixels< WireFormat::GRBW, Dither, true >( pixels, residual, out, scale );
+    }
+    else
+    {
+        levels = encodePixels< WireFormat::GRB, Dither, true >( pixels, residual, out, scale );
+    }
+    if ( Dither )
+    {
+        levels >>= 8;
+    }
+
+    // the frame got brighter than the budget allows, scale it down the rest of the way
+    uint16_t sent = m_limiter.update( levels, pixels.size( ) );
+    if ( sent < scale )
+    {
+        uint32_t ratio = ( uint32_t )sent * 256 / scale;
+        for ( size_t i = 0; i < size( pixels.size( ) ); ++i )
+        {
+            out[ i ] = ( out[ i ] * ratio ) >> 8;
+        }
+    }
+}
+
+void WireEncoder::encode( std::span< const Color::rgb32_t > pixels, uint8_t *out )
+{
+    encodeFrame< false >( pixels, nullptr, out );
+}
+
+void WireEncoder::encodeDithered( std::span< const Color::rgb32_t > pixels, uint8_t *residual, uint8_t *out )
+{
+    encodeFrame< true >( pixels, residual, out );
+}
+
+void WireEncoder::encodeReference( std::span< const Color::rgb32_t > pixels, uint8_t *out ) const
+{
+    bool ordered = !m_order.empty( ) && m_order.size( ) == pixels.size( );
+    for ( size_t i = 0; i < pixels.size( ); ++i )
+    {
+        const auto& pixel( pixels[ ordered ? m_order[ i ] : i ] );
+        if ( m_format == WireFormat::GRBW )
+        {
+            auto wrgb( m_white.extract( pixel ) );
+            *out++ = correct( wrgb.g( ), m_whiteBalance.g( ) );
+            *out++ = correct( wrgb.r( ), m_whiteBalance.r( ) );
+            *out++ = correct( wrgb.b( ), m_whiteBalance.b( ) );
+            *out++ = correct( wrgb.w( ), 255 );
+        }
+        else
+        {
+            *out++ = correct( pixel.g( ), m_whiteBalance.g( ) );
+            *out++ = correct( pixel.r( ), m_whiteBalance.r( ) );
+            *out++ = correct( pixel.b( ), m_whiteBalance.b( ) );
+        }
+    }
+}
+
+} // namespace Pattern
@@ -1,3 +1,4 @@
+#include "patterns/Program.h"
 #include "patterns/Sequence.h"
 #include "playback_task.h"
 #include "button_task.h"
@@ -6,6 +7,32 @@
 #include "controller_task.h"
 
 
+// send an example program to a slot, ahead of the step that plays it
+static void SendProgram(const ControllerConfig& config, uint8_t pattern)
+{
+    static uint8_t id = 0;
+    int slot = pattern - Pattern::Bytecode;
+    auto examples(Pattern::ExamplePrograms());
+    if (slot < 0 || slot >= Pattern::ProgramStore::Slots || slot >= (int)examples.size())
+    {
+        return;
+    }
+
+    uint8_t bytes[Pattern::Program::MaxSize];
+    Pattern::ProgramChunk chunks[Pattern::ProgramStore::MaxChunks];
+    size_t size = Pattern::Program::encode(examples[slot].duration, examples[slot].code, bytes);
+    size_t count = Pattern::ProgramStore::split(std::span(bytes, size), slot, ++id, chunks);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (config.master)
+        {
+            uint8_t broadcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+            esp_now_send( broadcast, reinterpret_cast<uint8_t *>(&chunks[i]), sizeof(chunks[i]));
+        }
+        xQueueSendToBack(config.programQueue, &chunks[i], 0);
+    }
+}
+
 void ControllerTask(/*ControllerConfig*/void *_config)
 {
     auto config(*static_cast<ControllerConfig *>(_config));
@@ -61,6 +88,12 @@ void ControllerTask(/*ControllerConfig*/void *_config)
             }
             ESP_LOGI("controller", "%s advance to step %d", button?"button":"timeout", step);
 
+            // send the program for the step first, nodes may have missed it
+            if (step != -1)
+            {
+                SendProgram(config, sequence->GetCommand(step).pattern);
+            }
+
             // create the playback event
 
             // transmit the new step, if master
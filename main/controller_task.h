@@ -8,6 +8,7 @@ struct ControllerConfig
     bool master;
     QueueHandle_t buttonQueue;
     QueueHandle_t playbackQueue;
+    QueueHandle_t programQueue;
 };
 
 void ControllerTask(/*ControllerConfig*/void *config);
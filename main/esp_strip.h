@@ -1,87 +1,202 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <span>
 #include <vector>
-#include "led_strip.h"
-#include "patterns/Strip.h"
+#include "esp_attr.h"
+#include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
+#include "patterns/BufferStrip.h"
+#include "patterns/WireEncoder.h"
+#include "led_encoder.h"
 
-class EspStrip : public Pattern::Strip
+class EspStrip : public Pattern::BufferStrip
 {
 public:
-    EspStrip( int gpio, size_t size)
-        : m_leds(size)
+    EspStrip( int gpio, size_t size, LedModel model = LedModel::WS2812,
+        Pattern::WireFormat format = Pattern::WireFormat::GRB)
+        : BufferStrip(size), m_encoder(format)
     {
-        //configure_led();
-        //ESP_LOGI(TAG, "Example configured to blink addressable LED!");
-        /* LED strip initialization with the GPIO and pixels number*/
-        led_strip_config_t strip_config = {
-            .strip_gpio_num = gpio,
-            .max_leds = size, // at least one LED on board
-            .led_pixel_format = LED_PIXEL_FORMAT_GRB,
-            .led_model = LED_MODEL_WS2812,
-            .flags = 0
+        for (auto& wire : m_wire)
+        {
+            wire.resize(m_encoder.size(size));
+        }
+
+        /* RMT channel on the GPIO, pixel bytes are encoded straight from m_wire */
+        rmt_tx_channel_config_t channel_config = {
+            .gpio_num = static_cast<gpio_num_t>(gpio),
+            .clk_src = RMT_CLK_SRC_DEFAULT,
+            .resolution_hz = RESOLUTION_HZ,
+            /* one block per channel, so every TX channel can get one, the
+               encoder refills it as it empties */
+            .mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL,
+            .trans_queue_depth = 4,
+            .flags = {},
         };
-        led_strip_rmt_config_t rmt_config = {
-            .resolution_hz = 10 * 1000 * 1000, // 10MHz
+        ESP_ERROR_CHECK(rmt_new_tx_channel(&channel_config, &m_channel));
+        LedEncoderConfig encoder_config = {
+            .resolution = RESOLUTION_HZ,
+            .model = model,
         };
-        ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &m_led_strip));
+        ESP_ERROR_CHECK(NewLedEncoder(encoder_config, &m_rmt_encoder));
+        rmt_tx_event_callbacks_t callbacks = {
+            .on_trans_done = OnTransmitDone,
+        };
+        ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(m_channel, &callbacks, this));
+        ESP_ERROR_CHECK(rmt_enable(m_channel));
         /* Set all LED off to clear all pixels */
-        led_strip_clear(m_led_strip);
+        transmit();
     }
 
-    // returns the number of pixels
-    virtual uint16_t numPixels( ) const override
+    // independent control of brightness
+    virtual void setBrightness( uint8_t bright ) override
     {
-        return m_leds.size();
+        BufferStrip::setBrightness(bright);
+        m_encoder.setBrightness(bright);
     }
 
-    // get a pixel color value
-    virtual Color::rgb32_t getPixelColor( uint16_t pixel ) const override
+    // output gamma curve, 1.0 is linear
+    void setGamma(float gamma)
     {
-        return m_leds[pixel];
+        m_encoder.setGamma(gamma);
+        markDirty();
     }
 
-    // set a single pixel to a color
-    virtual void setPixelColor( uint16_t pixel, Color::rgb32_t color ) override
+    // per channel white balance gains, 255 is unity
+    void setWhiteBalance(Color::rgb32_t gains)
     {
-        m_leds[pixel] = color;
+        m_encoder.setWhiteBalance(gains);
+        markDirty();
     }
 
-    // set all pixels to a color
-    virtual void setAllColor( Color::rgb32_t color ) override
+    // how white is mixed from RGB, for GRBW strips
+    void setWhiteExtractor(const Color::WhiteExtractor& white)
     {
-        for ( size_t pixel = 0; pixel < m_leds.size(); ++pixel )
-        {
-            m_leds[pixel] = color;
-        }
+        m_encoder.setWhiteExtractor(white);
+        markDirty();
     }
 
-    // independent control of brightness
-    virtual uint8_t getBrightness( ) const override
+    // estimated current limit in mA, 0 for no limit
+    void setPowerBudget(uint32_t milliamps)
     {
-        return m_brightness;
+        m_encoder.limiter().setBudget(milliamps);
+        markDirty();
     }
 
-    // independent control of brightness
-    virtual void setBrightness( uint8_t bright ) override
+    // estimated current of the last frame sent, in mA
+    uint32_t current() const
     {
-        m_brightness = bright;
+        return m_encoder.limiter().current();
     }
 
-    void transmit() const override
+    // wire order of the pixels, eg PixelMap::Serpentine(), empty for as rendered
+    void setOrder(std::span<const uint16_t> order)
     {
-        for ( size_t pixel = 0; pixel < m_leds.size(); ++pixel )
+        m_encoder.setOrder(order);
+        markDirty();
+    }
+
+    // temporal dithering of the 16 bit corrected output
+    //
+    // Dithered output changes every frame, so the strip re-encodes and sends
+    // every frame even when nothing changed, giving up the time and power that
+    // skipping unchanged frames saves.  Behind a CompositeStrip the channels are
+    // only sent when the composite changes, so a still frame stops on whatever
+    // residual it reached rather than dithering on.
+    void setDither(bool dither)
+    {
+        m_encoder.setDither(dither);
+        m_residual.assign(dither ? m_encoder.size(numPixels()) : 0, 0);
+        markDirty();
+    }
+
+    void transmit() override
+    {
+        transmitAsync();
+        waitTransmit(-1);
+    }
+
+    void transmitAsync() override
+    {
+        /* Dithered output changes every frame, even when the pixels don't, and
+           so does the output while the current limiter recovers */
+        if (m_encoder.dither() || m_encoder.limiter().recovering())
+        {
+            markDirty();
+        }
+
+        /* Nothing changed, the LEDs are already showing this frame */
+        if (!startFrame())
+        {
+            return;
+        }
+
+        /* The idle buffer is one sent frame behind, so bring over the pixels
+           changed in this frame and the last one.  Convert them to wire order
+           in one pass, while the previous frame may still be shifting out of
+           the other buffer */
+        auto& wire(m_wire[m_back]);
+        uint16_t first = std::min(dirtyFirst(), m_lastFirst);
+        uint16_t end = std::min(std::max(dirtyEnd(), m_lastEnd), numPixels());
+        m_lastFirst = dirtyFirst();
+        m_lastEnd = dirtyEnd();
+        clearDirty();
+        if (m_encoder.dither())
+        {
+            m_encoder.encodeDithered(m_pixels, m_residual.data(), wire.data());
+        }
+        else if (m_encoder.limiter().budget())
         {
-            led_strip_set_pixel(m_led_strip, pixel, 
-                m_leds[pixel].r() * m_brightness / 255, 
-                m_leds[pixel].g() * m_brightness / 255, 
-                m_leds[pixel].b() * m_brightness / 255);
+            /* The current estimate needs the whole frame */
+            m_encoder.encode(m_pixels, wire.data());
         }
-        /* Refresh the strip to send data */
-        led_strip_refresh(m_led_strip);
+        else if (first < end && m_encoder.ordered())
+        {
+            /* Reordered pixels land anywhere on the wire */
+            m_encoder.encode(m_pixels, wire.data());
+        }
+        else if (first < end)
+        {
+            m_encoder.encode(std::span(m_pixels).subspan(first, end - first),
+                wire.data() + m_encoder.size(first));
+        }
+
+        /* Only one frame in flight, so the next encode never touches a busy buffer */
+        waitTransmit(-1);
+        rmt_transmit_config_t transmit_config = {
+            .loop_count = 0,
+            .flags = {},
+        };
+        ESP_ERROR_CHECK(rmt_transmit(m_channel, m_rmt_encoder, wire.data(), wire.size(), &transmit_config));
+        m_back = (m_back + 1) % m_wire.size();
+    }
+
+    bool waitTransmit(uint32_t timeout) override
+    {
+        return rmt_tx_wait_all_done(m_channel, timeout) == ESP_OK;
+    }
+
+    // 1.2us per bit plus the reset
+    uint32_t transmitTime() const override
+    {
+        return m_encoder.size(numPixels()) * 8 * 12 / 10 + 80;
     }
 
 protected:
-    led_strip_handle_t m_led_strip;
-    std::vector<Color::rgb32_t> m_leds;
-    uint8_t m_brightness = 255;
+    static bool IRAM_ATTR OnTransmitDone(rmt_channel_handle_t, const rmt_tx_done_event_data_t *, void *strip)
+    {
+        static_cast<EspStrip *>(strip)->transmitDone();
+        return false;
+    }
+
+    static const uint32_t RESOLUTION_HZ = 10 * 1000 * 1000; // 10MHz
+
+    rmt_channel_handle_t m_channel;
+    rmt_encoder_handle_t m_rmt_encoder;
+    std::array<std::vector<uint8_t>, 2> m_wire; // wire order, output correction applied
+    size_t m_back = 0; // the wire buffer not being transmitted
+    uint16_t m_lastFirst = 0, m_lastEnd = UINT16_MAX; // pixels changed in the last frame sent
+    std::vector<uint8_t> m_residual; // dither fraction carried to the next frame, in wire order
+    Pattern::WireEncoder m_encoder;
 };
@@ -0,0 +1,136 @@
+#include <cstddef>
+#include <cstdlib>
+#include "esp_check.h"
+#include "led_encoder.h"
+
+
+// bit timing
+struct LedTiming
+{
+    uint32_t t0h, t0l, t1h, t1l;    // ns
+    uint32_t reset;                 // us
+};
+
+static const LedTiming WS2812_TIMING = {300, 900, 900, 300, 50};
+static const LedTiming SK6812_TIMING = {300, 900, 600, 600, 80};
+
+struct LedEncoder
+{
+    rmt_encoder_t base;             // must be first, it's all the RMT driver sees
+    rmt_encoder_handle_t bytes;     // shifts out the pixel data
+    rmt_encoder_handle_t copy;      // shifts out the reset code
+    int state;                      // 0 while sending pixel data, 1 while sending reset
+    rmt_symbol_word_t reset;
+};
+static_assert(offsetof(LedEncoder, base) == 0);
+
+static size_t EncodeLeds(rmt_encoder_t *_encoder, rmt_channel_handle_t channel,
+    const void *data, size_t size, rmt_encode_state_t *ret_state)
+{
+    auto encoder(reinterpret_cast<LedEncoder *>(_encoder));
+    rmt_encode_state_t session = RMT_ENCODING_RESET;
+    int state = RMT_ENCODING_RESET;
+    size_t symbols = 0;
+    switch (encoder->state)
+    {
+    case 0:
+        // pixel data
+        symbols += encoder->bytes->encode(encoder->bytes, channel, data, size, &session);
+        if (session & RMT_ENCODING_COMPLETE)
+        {
+            encoder->state = 1;
+        }
+        if (session & RMT_ENCODING_MEM_FULL)
+        {
+            // out of symbol memory, yield until the driver comes back for more
+            state |= RMT_ENCODING_MEM_FULL;
+            break;
+        }
+        [[fallthrough]];
+
+    case 1:
+        // reset code
+        symbols += encoder->copy->encode(encoder->copy, channel, &encoder->reset, sizeof(encoder->reset), &session);
+        if (session & RMT_ENCODING_COMPLETE)
+        {
+            encoder->state = 0;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session & RMT_ENCODING_MEM_FULL)
+        {
+            state |= RMT_ENCODING_MEM_FULL;
+        }
+        break;
+    }
+    *ret_state = static_cast<rmt_encode_state_t>(state);
+    return symbols;
+}
+
+static esp_err_t ResetLeds(rmt_encoder_t *_encoder)
+{
+    auto encoder(reinterpret_cast<LedEncoder *>(_encoder));
+    rmt_encoder_reset(encoder->bytes);
+    rmt_encoder_reset(encoder->copy);
+    encoder->state = 0;
+    return ESP_OK;
+}
+
+static esp_err_t DeleteLeds(rmt_encoder_t *_encoder)
+{
+    auto encoder(reinterpret_cast<LedEncoder *>(_encoder));
+    if (encoder->bytes)
+    {
+        rmt_del_encoder(encoder->bytes);
+    }
+    if (encoder->copy)
+    {
+        rmt_del_encoder(encoder->copy);
+    }
+    free(encoder);
+    return ESP_OK;
+}
+
+esp_err_t NewLedEncoder(const LedEncoderConfig& config, rmt_encoder_handle_t *ret_encoder)
+{
+    ESP_RETURN_ON_FALSE(ret_encoder, ESP_ERR_INVALID_ARG, "led_encoder", "invalid argument");
+    auto encoder(static_cast<LedEncoder *>(calloc(1, sizeof(LedEncoder))));
+    ESP_RETURN_ON_FALSE(encoder, ESP_ERR_NO_MEM, "led_encoder", "no memory for encoder");
+    encoder->base.encode = EncodeLeds;
+    encoder->base.reset = ResetLeds;
+    encoder->base.del = DeleteLeds;
+
+    // bit timing, in ticks
+    const LedTiming& timing(config.model == LedModel::SK6812 ? SK6812_TIMING : WS2812_TIMING);
+    const uint32_t ticksPerUs = config.resolution / 1000000;
+    rmt_bytes_encoder_config_t bytesConfig = {};
+    bytesConfig.bit0.level0 = 1;
+    bytesConfig.bit0.duration0 = timing.t0h * ticksPerUs / 1000;
+    bytesConfig.bit0.level1 = 0;
+    bytesConfig.bit0.duration1 = timing.t0l * ticksPerUs / 1000;
+    bytesConfig.bit1.level0 = 1;
+    bytesConfig.bit1.duration0 = timing.t1h * ticksPerUs / 1000;
+    bytesConfig.bit1.level1 = 0;
+    bytesConfig.bit1.duration1 = timing.t1l * ticksPerUs / 1000;
+    bytesConfig.flags.msb_first = 1;
+    esp_err_t err = rmt_new_bytes_encoder(&bytesConfig, &encoder->bytes);
+    if (err == ESP_OK)
+    {
+        rmt_copy_encoder_config_t copyConfig = {};
+        err = rmt_new_copy_encoder(&copyConfig, &encoder->copy);
+    }
+    if (err != ESP_OK)
+    {
+        DeleteLeds(&encoder->base);
+        return err;
+    }
+
+    // reset is the line held low, split across both halves of one symbol
+    const uint32_t resetTicks = timing.reset * ticksPerUs / 2;
+    encoder->reset.level0 = 0;
+    encoder->reset.duration0 = resetTicks;
+    encoder->reset.level1 = 0;
+    encoder->reset.duration1 = resetTicks;
+
+    *ret_encoder = &encoder->base;
+    return ESP_OK;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include "driver/rmt_encoder.h"
+
+// LED driver chip, for the bit timing
+enum class LedModel
+{
+    WS2812,
+    SK6812,
+};
+
+struct LedEncoderConfig
+{
+    uint32_t resolution;        // RMT tick rate, in Hz
+    LedModel model = LedModel::WS2812;
+};
+
+/**
+ * Creates an RMT encoder that shifts out a buffer of wire order bytes (see
+ * Pattern::WireEncoder) with the model's bit timing, followed by the reset code that
+ * latches the frame.
+ */
+esp_err_t NewLedEncoder(const LedEncoderConfig& config, rmt_encoder_handle_t *encoder);
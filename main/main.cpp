@@ -4,7 +4,9 @@ RadioPixel esp32 node
 Copyright (c) 2023 Jonathan Kemble
 */
 #include <stdio.h>
+#include <array>
 #include <cstring>
+#include <iterator>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -19,16 +21,43 @@ Copyright (c) 2023 Jonathan Kemble
 #include "controller_task.h"
 #include "playback_task.h"
 #include "esp_strip.h"
+#include "pattern_benchmark.h"
+#include "patterns/CompositeStrip.h"
+#include "patterns/EffectStrip.h"
+#include "patterns/PixelMap.h"
 
 
+// an LED output, patterns see all outputs joined end to end
+struct LedChannel
+{
+    gpio_num_t gpio;
+    uint16_t count;
+    bool reversed;
+    LedModel model = LedModel::WS2812;
+    Pattern::WireFormat format = Pattern::WireFormat::GRB;
+    uint16_t width = 0; // row length of a serpentine matrix, 0 for a strip
+};
+
 #define RADIOPIXEL2_2 1
 
+// time the patterns at startup instead of running, see pattern_benchmark.h
+//#define PATTERN_BENCHMARK 1
+
 #if defined( DEVKIT)
 
-const auto LED_GPIO = GPIO_NUM_8;
-const int LED_COUNT = 60;
+const LedChannel LED_CHANNELS[] = {
+    { GPIO_NUM_8, 60, false },
+};
 const int LED_REFRESH_RATE = 40; // Hz
 const int LED_MAX_INTENSITY = 192;
+const float LED_GAMMA = 2.2f;
+const Color::rgb32_t LED_WHITE_BALANCE(255, 255, 255);
+const bool LED_DITHER = false; // temporal dithering, sends every frame even when unchanged
+const uint32_t LED_POWER_BUDGET = 500; // mA for all channels, 0 for no limit
+const Color::rgb32_t LED_WHITE_MIX(255, 255, 255); // RGB matching the white emitter, RGBW strips only
+const Pattern::ms_t LED_LOOP_CACHE_MS = 20; // loop cache resolution, 0 for no loop cache
+const size_t LED_LOOP_CACHE_BYTES = 48 * 1024; // most memory for a cached loop
+constexpr std::array<Pattern::Effect, 0> LED_EFFECTS{}; // post processing, eg {{Pattern::Effect::Repeat, 60}}
 
 const auto BUTTON_1_GPIO = GPIO_NUM_9;
 const auto BUTTON_LONGPRESS_MS = 1500;
@@ -37,10 +66,19 @@ const uint8_t WIFI_CHANNEL = 6;
 
 #elif defined(RADIOPIXEL2_0)
 
-const auto LED_GPIO = GPIO_NUM_7;
-const int LED_COUNT = 60;
+const LedChannel LED_CHANNELS[] = {
+    { GPIO_NUM_7, 60, false },
+};
 const int LED_REFRESH_RATE = 40; // Hz
 const int LED_MAX_INTENSITY = 128;
+const float LED_GAMMA = 2.2f;
+const Color::rgb32_t LED_WHITE_BALANCE(255, 255, 255);
+const bool LED_DITHER = false; // temporal dithering, sends every frame even when unchanged
+const uint32_t LED_POWER_BUDGET = 2000; // mA for all channels, 0 for no limit
+const Color::rgb32_t LED_WHITE_MIX(255, 255, 255); // RGB matching the white emitter, RGBW strips only
+const Pattern::ms_t LED_LOOP_CACHE_MS = 20; // loop cache resolution, 0 for no loop cache
+const size_t LED_LOOP_CACHE_BYTES = 48 * 1024; // most memory for a cached loop
+constexpr std::array<Pattern::Effect, 0> LED_EFFECTS{}; // post processing, eg {{Pattern::Effect::Repeat, 60}}
 
 const auto BUTTON_1_GPIO = GPIO_NUM_2;
 const auto BUTTON_LONGPRESS_MS = 1500;
@@ -49,10 +87,19 @@ const uint8_t WIFI_CHANNEL = 6;
 
 #elif defined(RADIOPIXEL2_2)
 
-const auto LED_GPIO = GPIO_NUM_7;
-const int LED_COUNT = 60;
+const LedChannel LED_CHANNELS[] = {
+    { GPIO_NUM_7, 60, false },
+};
 const int LED_REFRESH_RATE = 40; // Hz
 const int LED_MAX_INTENSITY = 128;
+const float LED_GAMMA = 2.2f;
+const Color::rgb32_t LED_WHITE_BALANCE(255, 255, 255);
+const bool LED_DITHER = false; // temporal dithering, sends every frame even when unchanged
+const uint32_t LED_POWER_BUDGET = 2000; // mA for all channels, 0 for no limit
+const Color::rgb32_t LED_WHITE_MIX(255, 255, 255); // RGB matching the white emitter, RGBW strips only
+const Pattern::ms_t LED_LOOP_CACHE_MS = 20; // loop cache resolution, 0 for no loop cache
+const size_t LED_LOOP_CACHE_BYTES = 48 * 1024; // most memory for a cached loop
+constexpr std::array<Pattern::Effect, 0> LED_EFFECTS{}; // post processing, eg {{Pattern::Effect::Repeat, 60}}
 
 const auto BUTTON_1_GPIO = GPIO_NUM_1;
 const auto BUTTON_2_GPIO = GPIO_NUM_2;
@@ -87,6 +134,7 @@ static void app_wifi_init()
 }
 
 QueueHandle_t _playbackQueue;
+QueueHandle_t _programQueue;
 
 void OnDataRecv(const esp_now_recv_info_t * esp_now_info, const uint8_t *data, int data_len) 
 {
@@ -99,16 +147,28 @@ void OnDataRecv(const esp_now_recv_info_t * esp_now_info, const uint8_t *data, i
     {
         xQueueSendToBack(_playbackQueue, data, 0);
     }
+    else if(data_len == sizeof(Pattern::ProgramChunk))
+    {
+        xQueueSendToBack(_programQueue, data, 0);
+    }
 }    
 
 extern "C" void app_main(void)
 {
+#if defined(PATTERN_BENCHMARK)
+    // in its own task, the main task's stack is too small for the patterns
+    static uint32_t benchmark_frames = 40;
+    xTaskCreate(PatternBenchmarkTask, "benchmark", 32*1024, &benchmark_frames, 5, NULL);
+    return;
+#endif
+
     // Dan said do this .. ?
     gpio_set_level(GPIO_NUM_6, 1);
 
     // the event queues
     QueueHandle_t buttonQueue = xQueueCreate(10, sizeof( ButtonEvent ));
     QueueHandle_t playbackQueue = xQueueCreate(10, sizeof( PlaybackEvent ));
+    QueueHandle_t programQueue = xQueueCreate(2 * Pattern::ProgramStore::MaxChunks, sizeof( Pattern::ProgramChunk ));
 
     // start the button task
     ButtonConfig button_1_cfg{BUTTON_1_GPIO, 0, BUTTON_LONGPRESS_MS, 1, buttonQueue};
@@ -117,7 +177,7 @@ extern "C" void app_main(void)
 
     // start the local control task
     bool master(gpio_get_level(button_1_cfg.gpio) == button_1_cfg.pressed_level);
-    ControllerConfig local{master, buttonQueue, playbackQueue};
+    ControllerConfig local{master, buttonQueue, playbackQueue, programQueue};
     TaskHandle_t local_task;
     xTaskCreate(ControllerTask, "local", 32*1024, &local, 5, &local_task);
 
@@ -134,11 +194,81 @@ extern "C" void app_main(void)
     //broadcast.channel = WIFI_CHANNEL;
     esp_now_add_peer(&broadcast);
     _playbackQueue = playbackQueue;
+    _programQueue = programQueue;
     esp_now_register_recv_cb(OnDataRecv);
 
+    // setup the LEDs, the power budget is shared by pixel count
+    uint32_t ledPixels = 0;
+    for (const auto& channel : LED_CHANNELS)
+    {
+        ledPixels += channel.count;
+    }
+    auto newChannel = [ledPixels](const LedChannel& channel)
+    {
+        auto output(new EspStrip(channel.gpio, channel.count, channel.model, channel.format));
+        output->setGamma(LED_GAMMA);
+        if (channel.format == Pattern::WireFormat::GRBW)
+        {
+            output->setWhiteExtractor(Color::WhiteExtractor(LED_WHITE_MIX));
+        }
+        output->setWhiteBalance(LED_WHITE_BALANCE);
+        output->setDither(LED_DITHER);
+        output->setPowerBudget(LED_POWER_BUDGET * channel.count / ledPixels);
+        if (channel.width)
+        {
+            output->setOrder(Pattern::PixelMap::Serpentine(channel.width, channel.count / channel.width));
+        }
+        return output;
+    };
+    Pattern::Strip *strip;
+    if (std::size(LED_CHANNELS) == 1 && !LED_CHANNELS[0].reversed)
+    {
+        strip = newChannel(LED_CHANNELS[0]);
+
+        // patterns that work across space see the matrix
+        const auto& channel(LED_CHANNELS[0]);
+        if (channel.width)
+        {
+            strip->setPixelMap(new Pattern::PixelMap(
+                Pattern::PixelMap::Matrix(channel.width, channel.count / channel.width)));
+        }
+    }
+    else
+    {
+        // one channel per output, all shifting out at the same time
+        auto composite(new Pattern::CompositeStrip());
+        for (const auto& channel : LED_CHANNELS)
+        {
+            composite->addSegment({newChannel(channel), 0, channel.count, channel.reversed});
+        }
+        strip = composite;
+    }
+
+    // post processing between the patterns and the LEDs
+    if (!LED_EFFECTS.empty())
+    {
+        auto effects(new Pattern::EffectStrip(strip));
+        effects->setEffects(LED_EFFECTS);
+
+        // the layout only fits when no effect shrinks the strip, otherwise the
+        // patterns render along the strip
+        if (effects->numPixels() == strip->numPixels())
+        {
+            effects->setPixelMap(strip->pixelMap());
+        }
+        else if (strip->pixelMap())
+        {
+            ESP_LOGW("main", "layout dropped, %d effect pixels for %d LEDs", effects->numPixels(), strip->numPixels());
+        }
+        strip = effects;
+    }
+
+    // the LEDs hold their state, so only refresh unchanged frames about once a second
+    strip->setSkipUnchanged(true, LED_REFRESH_RATE);
+
     // start the playback task
-    auto strip(new EspStrip(LED_GPIO, LED_COUNT));
-    PlaybackConfig playbackConfig{playbackQueue, strip, LED_REFRESH_RATE, LED_MAX_INTENSITY};
+    PlaybackConfig playbackConfig{playbackQueue, programQueue, strip, LED_REFRESH_RATE, LED_MAX_INTENSITY,
+        LED_LOOP_CACHE_MS, LED_LOOP_CACHE_BYTES};
     TaskHandle_t playback_task;
     xTaskCreate(PlaybackTask, "playback", 32*1024, &playbackConfig, 5, &playback_task);
 
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "patterns/Benchmark.h"
+#include "patterns/Program.h"
+#include "pattern_benchmark.h"
+
+
+// the cycle counter extended to 64 bits, it wraps every 27s at 160MHz
+static uint64_t cycles()
+{
+    static uint64_t total = 0;
+    static uint32_t last = esp_cpu_get_cycle_count();
+    uint32_t now = esp_cpu_get_cycle_count();
+    total += now - last;
+    last = now;
+    return total;
+}
+
+void PatternBenchmark(uint32_t frames)
+{
+    // the example programs in the first slots, as on the host
+    uint8_t slot = 0;
+    for (const auto& example : Pattern::ExamplePrograms())
+    {
+        uint8_t bytes[Pattern::Program::MaxSize];
+        size_t size = Pattern::Program::encode(example.duration, example.code, bytes);
+        Pattern::Programs().program(slot++).load(std::span(bytes, size));
+    }
+
+    // plain lines rather than logs, so the output can be cut straight out of the monitor
+    Pattern::Benchmark benchmark(cycles);
+    printf("pattern,name,pixels,speed,level,frames,init_cycles,cycles_per_frame,cycles_per_pixel\n");
+    benchmark.runAll(frames, [](const Pattern::Benchmark::Result& result)
+    {
+        const auto& test(result.test);
+        const char *name = (test.pattern >= Pattern::Bytecode)
+            ? Pattern::ExamplePrograms()[test.pattern - Pattern::Bytecode].name : Pattern::PatternName(test.pattern);
+        printf("%u,%s,%u,%u,%u,%lu,%llu,%.1f,%.3f\n", test.pattern, name, test.pixels, test.speed, test.level,
+            (unsigned long)result.frames, (unsigned long long)result.init, result.perFrame(), result.perPixel());
+
+        // let the idle task run, so the watchdog doesn't trip
+        vTaskDelay(1);
+    });
+}
+
+void PatternBenchmarkTask(/*uint32_t frames*/void *frames)
+{
+    PatternBenchmark(*static_cast<uint32_t *>(frames));
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// time each pattern on the ESP32, printing CSV in cycles like tools/hostplayer patternbench
+void PatternBenchmark(uint32_t frames);
+
+// runs PatternBenchmark in a task of its own, the suite needs more stack than
+// app_main has, deletes itself when done
+void PatternBenchmarkTask(/*uint32_t frames*/void *frames);
@@ -1,5 +1,6 @@
 #include <map>
 #include "patterns/Player.h"
+#include "patterns/Program.h"
 #include "esp_log.h"
 #include "playback_task.h"
 
@@ -12,18 +13,30 @@ void PlaybackTask(/*PlaybackConfig*/void *_config)
     std::map<PlaybackEvent::Source, PlaybackEvent> stack;
 
     Pattern::Player player;
+    player.setLoopCache(config.loop_cache_ms, config.loop_cache_bytes);
     auto now = xTaskGetTickCount() * portTICK_PERIOD_MS;
     player.UpdatePattern( now, Pattern::PlayerControl(), config.strip );
     config.strip->transmit();
+    auto wake = xTaskGetTickCount();
     while (1)
     {
         auto now = xTaskGetTickCount() * portTICK_PERIOD_MS;
 
+        // load any programs that came in, between frames so none is played half loaded
+        Pattern::ProgramChunk chunk;
+        while ( xQueueReceive(config.programQueue, &chunk, 0))
+        {
+            if (Pattern::Programs().receive(chunk)) {
+                ESP_LOGI("playback", "loaded program %d", (int)chunk.slot);
+            }
+        }
+
         // process any events that came in
         PlaybackEvent event;
         while ( xQueueReceive(config.queue, &event, 0))
         {
             ESP_LOGI("playback", "Received source %d, command %d, pattern %d", (int)event.source, (int)event.command, (int)event.control.pattern);
+            ESP_LOGI("playback", "frames sent %lu, skipped %lu", (unsigned long)config.strip->framesSent(), (unsigned long)config.strip->framesSkipped());
             if (config.max_intensity) {
                 event.control.intensity = config.max_intensity;
             }
@@ -40,10 +53,10 @@ void PlaybackTask(/*PlaybackConfig*/void *_config)
         // render the pattern to the strip, in case there were no events
         player.UpdateStrip( now, config.strip );
 
-        // output the strip to hardware
-        config.strip->transmit();
+        // start output to hardware, the next frame renders while this one shifts out
+        config.strip->transmitAsync();
 
-        // wait the refresh period
-        vTaskDelay(pdMS_TO_TICKS(1000 / config.refresh_rate));
+        // wait the rest of the refresh period
+        xTaskDelayUntil(&wake, pdMS_TO_TICKS(1000 / config.refresh_rate));
     }
 }
@@ -7,9 +7,12 @@
 struct PlaybackConfig
 {
     QueueHandle_t queue;
+    QueueHandle_t programQueue; // Pattern::ProgramChunk
     Pattern::Strip *strip;
     int refresh_rate; // Hz
     uint8_t max_intensity = 0;
+    Pattern::ms_t loop_cache_ms = 0; // play cacheable patterns from frames at this resolution, 0 for none
+    size_t loop_cache_bytes = 0;
 };
 
 struct PlaybackEvent
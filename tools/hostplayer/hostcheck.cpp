@@ -0,0 +1,494 @@
+/*
+RadioPixel host checks
+
+Checks the color kernels against their reference forms, and the strip
+plumbing, on the host.  Prints each failure and exits non-zero if any check
+fails; run it through ctest.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "color/Frame.h"
+#include "color/RGBW.h"
+#include "patterns/CompositeStrip.h"
+#include "patterns/EffectStrip.h"
+#include "patterns/HostStrip.h"
+#include "patterns/PixelMap.h"
+#include "patterns/Player.h"
+#include "patterns/PowerLimiter.h"
+#include "patterns/Program.h"
+#include "patterns/WireEncoder.h"
+
+using namespace Color;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static bool near(int a, int b, int tolerance)
+{
+    return abs(a - b) <= tolerance;
+}
+
+// FadeFrame and BlendFrames match ColorFade and ColorBlend exactly, for every
+// pair of channel values in each byte position at every level
+static void checkFrameKernels()
+{
+    std::vector<rgb32_t> a, b;
+    for (int x = 0; x < 256; ++x) {
+        for (int y = 0; y < 256; ++y) {
+            a.push_back(rgb32_t(x, y, (x * 7) & 255, x ^ y));
+            b.push_back(rgb32_t(y, (x * 3) & 255, x, y));
+        }
+    }
+
+    long fades = 0, blends = 0, inPlace = 0;
+    std::vector<rgb32_t> out(a.size());
+    for (int level = 0; level < 256; ++level) {
+        out = a;
+        FadeFrame(out, level);
+        for (size_t i = 0; i < a.size(); ++i) {
+            fades += out[i] != ColorFade(a[i], level);
+        }
+
+        BlendFrames(out, a, b, level);
+        for (size_t i = 0; i < a.size(); ++i) {
+            blends += out[i] != ColorBlend(a[i], b[i], level);
+        }
+
+        out = b;
+        BlendFrames(out, a, out, level);
+        for (size_t i = 0; i < a.size(); ++i) {
+            inPlace += out[i] != ColorBlend(a[i], b[i], level);
+        }
+    }
+    check(fades == 0, "FadeFrame matches ColorFade");
+    check(blends == 0, "BlendFrames matches ColorBlend");
+    check(inPlace == 0, "BlendFrames in place matches ColorBlend");
+
+    // the scalar fade reaches both ends
+    long ends = 0;
+    for (int low = 0; low < 256; ++low) {
+        for (int high = 0; high < 256; ++high) {
+            ends += fade(low, high, 0) != low || fade(low, high, 255) != high;
+        }
+    }
+    check(ends == 0, "fade reaches both ends");
+}
+
+// the fast encoder matches the per pixel reference byte for byte
+static void checkEncoder()
+{
+    const uint16_t width = 12, height = 10;
+    std::vector<rgb32_t> frame(width * height);
+    for (size_t i = 0; i < frame.size(); ++i) {
+        frame[i] = rgb32_t((i * 37) & 255, (i * 91 + 13) & 255, (i * 13 + 200) & 255);
+    }
+    frame[0] = rgb32_t::White();
+    frame[1] = rgb32_t::Black();
+    const auto serpentine(Pattern::PixelMap::Serpentine(width, height));
+
+    long mismatches = 0;
+    for (auto format : {Pattern::WireFormat::GRB, Pattern::WireFormat::GRBW}) {
+        for (float gamma : {1.0f, 2.2f}) {
+            for (uint8_t brightness : {255, 192, 64, 1, 0}) {
+                for (rgb32_t balance : {rgb32_t(255, 255, 255), rgb32_t(255, 200, 150)}) {
+                    for (bool ordered : {false, true}) {
+                        Pattern::WireEncoder encoder(format);
+                        encoder.setGamma(gamma);
+                        encoder.setBrightness(brightness);
+                        encoder.setWhiteBalance(balance);
+                        encoder.setWhiteExtractor(WhiteExtractor(rgb32_t(255, 220, 180)));
+                        if (ordered) {
+                            encoder.setOrder(serpentine);
+                        }
+                        std::vector<uint8_t> fast(encoder.size(frame.size())), reference(fast.size());
+                        encoder.encode(frame, fast.data());
+                        encoder.encodeReference(frame, reference.data());
+                        mismatches += fast != reference;
+                    }
+                }
+            }
+        }
+    }
+    check(mismatches == 0, "encode matches encodeReference");
+}
+
+// a Gradient's palette follows its steps as they change
+static void checkGradient()
+{
+    Gradient gradient;
+    check(gradient.getColor(128) == 0, "empty gradient is black");
+
+    gradient.addStep(0, rgb32_t(0, 0, 0));
+    gradient.addStep(255, rgb32_t(255, 0, 254));
+    check(gradient.getColor(0) == rgb32_t(0, 0, 0) && gradient.getColor(255) == rgb32_t(255, 0, 254),
+        "gradient ends are the end steps");
+    check(gradient.getColor(51) == ColorBlend(rgb32_t(0, 0, 0), rgb32_t(255, 0, 254), 51), "gradient blends between steps");
+
+    const Gradient::Step steps[] = {{0, rgb32_t::Red()}, {128, rgb32_t::Green()}, {255, rgb32_t::Blue()}};
+    gradient.setSteps(steps, 3);
+    check(gradient.getColor(0) == rgb32_t::Red() && gradient.getColor(128) == rgb32_t::Green()
+        && gradient.getColor(255) == rgb32_t::Blue(), "gradient follows new steps");
+
+    gradient.clearSteps();
+    check(gradient.getColor(0) == 0 && gradient.getColor(255) == 0, "cleared gradient is black");
+}
+
+// the limiter keeps frames in budget at once, recovers gradually, and the encoder sends at its scale
+static void checkPowerLimiter()
+{
+    const size_t pixels = 60;
+    const uint32_t white = pixels * 3 * 255;
+
+    // over budget, sent in budget in the same frame
+    Pattern::PowerLimiter limiter;
+    limiter.setBudget(500);
+    check(limiter.estimate(white, pixels) > 500, "white frame is over budget");
+    uint16_t sent = limiter.update(white, pixels);
+    check(sent < Pattern::PowerLimiter::Unity, "white frame is scaled");
+    check(limiter.current() <= 500, "white frame is sent in budget");
+
+    // dark frames recover towards unity over several frames
+    int recovering = 0;
+    bool rising = true;
+    for (int frame = 0; frame < 200 && limiter.scale() < Pattern::PowerLimiter::Unity; ++frame) {
+        uint16_t last = limiter.scale();
+        limiter.update(0, pixels);
+        rising = rising && limiter.scale() > last;
+        check(limiter.recovering() == (limiter.scale() < Pattern::PowerLimiter::Unity), "recovering until back at unity");
+        ++recovering;
+    }
+    check(rising, "scale rises each dark frame");
+    check(recovering > 3, "scale recovers over several frames");
+    check(limiter.scale() == Pattern::PowerLimiter::Unity && !limiter.recovering(), "scale recovers to unity");
+
+    // no budget, no limit
+    Pattern::PowerLimiter unlimited;
+    check(unlimited.update(white, pixels) == Pattern::PowerLimiter::Unity, "no budget never scales");
+    check(unlimited.update(white * 100, pixels * 100) == Pattern::PowerLimiter::Unity, "no budget never scales big frames");
+    check(!unlimited.recovering(), "no budget never recovers");
+
+    // the encoder's output is dimmed to the scale it was sent at
+    const std::vector<rgb32_t> frame(pixels, rgb32_t::White());
+    Pattern::WireEncoder full, limited;
+    limited.limiter().setBudget(500);
+    std::vector<uint8_t> fullOut(full.size(pixels)), limitedOut(limited.size(pixels));
+    full.encode(frame, fullOut.data());
+    limited.encode(frame, limitedOut.data());
+    sent = limited.limiter().scale();
+    bool dimmed = sent < Pattern::PowerLimiter::Unity;
+    for (size_t i = 0; i < fullOut.size(); ++i) {
+        dimmed = dimmed && near(limitedOut[i], fullOut[i] * sent / Pattern::PowerLimiter::Unity, 1);
+    }
+    check(dimmed, "encoded frame is dimmed to the limiter scale");
+    check(limited.limiter().current() <= 500, "encoded frame is in budget");
+}
+
+// WhiteFromEmitters computes a mix that WhiteExtractor moves fully onto W
+static void checkWhiteFromEmitters()
+{
+    typedef CIEXYZ::xyY<double> xyY;
+    // sRGB primaries, their luminances add up to a D65 white at 1
+    const std::array<xyY, 3> srgb{ xyY(0.64, 0.33, 0.2126), xyY(0.30, 0.60, 0.7152), xyY(0.15, 0.06, 0.0722) };
+
+    rgb32_t mix(WhiteFromEmitters(srgb, xyY(0.3127, 0.3290, 1.0)).white());
+    check(near(mix.r(), 255, 1) && near(mix.g(), 255, 1) && near(mix.b(), 255, 1), "D65 white mixes full RGB");
+
+    // a brighter white than the RGB can reach is dimmed to the brightest mix
+    mix = WhiteFromEmitters(srgb, xyY(0.3127, 0.3290, 2.0)).white();
+    check(near(mix.r(), 255, 1) && near(mix.g(), 255, 1) && near(mix.b(), 255, 1), "bright D65 white clamps to full RGB");
+
+    // a warm white at half luminance, red leads and blue trails
+    WhiteExtractor warm(WhiteFromEmitters(srgb, xyY(0.4369, 0.4041, 0.5)));
+    mix = warm.white();
+    check(mix.r() > mix.g() && mix.g() > mix.b() && mix.b() > 0, "warm white mix is red heavy");
+
+    // the mix itself comes out as full white with nothing left over
+    wrgb32_t split(warm.extract(mix));
+    check(split.w() >= 254 && split.r() <= 1 && split.g() <= 1 && split.b() <= 1, "warm white mix extracts to W");
+
+    // half the mix is about half white, the extractor's 8.8 reciprocals round
+    // the white down a few steps and leave that in the RGB
+    split = warm.extract(rgb32_t(mix.r() / 2, mix.g() / 2, mix.b() / 2));
+    check(near(split.w(), 127, 5) && split.r() <= 5 && split.g() <= 5 && split.b() <= 5, "half warm mix extracts to half W");
+
+    // a white outside the gamut extracts nothing
+    WhiteExtractor none(WhiteFromEmitters(srgb, xyY(0.10, 0.80, 1.0)));
+    check(none.white() == 0, "out of gamut white has no mix");
+    check(none.extract(rgb32_t::White()).w() == 0, "out of gamut white extracts no W");
+}
+
+// segments map and copy to their channels, and a frame takes as long as the slowest channel
+static void checkCompositeMap()
+{
+    Pattern::BufferStrip a(20), b(8);
+    Pattern::CompositeStrip composite;
+    composite.addSegment({&a, 5, 10, false});
+    composite.addSegment({&b, 2, 6, true});
+    check(composite.numPixels() == 16, "composite is the segments end to end");
+
+    check(composite.map(0) == std::make_pair<Pattern::Strip *, uint16_t>(&a, 5), "map offset segment start");
+    check(composite.map(9) == std::make_pair<Pattern::Strip *, uint16_t>(&a, 14), "map offset segment end");
+    check(composite.map(10) == std::make_pair<Pattern::Strip *, uint16_t>(&b, 7), "map reversed segment start");
+    check(composite.map(15) == std::make_pair<Pattern::Strip *, uint16_t>(&b, 2), "map reversed segment end");
+    check(composite.map(16) == std::make_pair<Pattern::Strip *, uint16_t>(nullptr, 0), "map past the end");
+
+    for (uint16_t i = 0; i < composite.numPixels(); ++i) {
+        composite.setPixelColor(i, rgb32_t(i + 1, 2 * i, 255 - i));
+    }
+    composite.transmit();
+    bool placed = true;
+    for (uint16_t i = 0; i < composite.numPixels(); ++i) {
+        auto [channel, pixel] = composite.map(i);
+        placed = placed && channel->getPixelColor(pixel) == rgb32_t(i + 1, 2 * i, 255 - i);
+    }
+    check(placed, "segments copy to where map says");
+    check(a.getPixelColor(4) == 0 && a.getPixelColor(15) == 0 && b.getPixelColor(1) == 0, "pixels outside segments untouched");
+
+    check(composite.transmitTime() == std::max(a.transmitTime(), b.transmitTime()), "composite time is the slowest channel");
+}
+
+// a composite frame completes even when only some channels changed
+static void checkCompositeDone()
+{
+    Pattern::HostStrip a(10), b(10);
+    a.setSkipUnchanged(true);
+    b.setSkipUnchanged(true);
+    Pattern::CompositeStrip composite;
+    composite.addSegment({&a, 0, 10, false});
+    composite.addSegment({&b, 0, 10, false});
+    composite.setSkipUnchanged(true);
+    int done = 0;
+    composite.setTransmitDone([](void *count) { ++*static_cast<int *>(count); }, &done);
+
+    composite.transmitAsync();
+    composite.waitTransmit(-1);
+    check(done == 1, "composite first frame completes");
+
+    composite.setPixelColor(2, rgb32_t(1, 2, 3));
+    composite.transmitAsync();
+    composite.waitTransmit(-1);
+    check(done == 2, "composite frame with one channel changed completes");
+
+    composite.transmitAsync();
+    composite.waitTransmit(-1);
+    check(done == 2, "unchanged composite frame is skipped");
+}
+
+// decay trails fade by the amount, always reach black, and stop being sent once they do
+static void checkDecay()
+{
+    for (uint16_t amount : {0, 1, 64, 255, 1000}) {
+        Pattern::BufferStrip out(10);
+        Pattern::EffectStrip effects(&out);
+        effects.setSkipUnchanged(true);
+        const Pattern::Effect chain[] = {{Pattern::Effect::Decay, amount}};
+        effects.setEffects(chain);
+
+        effects.setPixelColor(3, rgb32_t::White());
+        effects.transmit();
+        effects.setPixelColor(3, rgb32_t::Black());
+        effects.transmit();
+        const int fade = std::clamp<int>(amount, 1, 255);
+        check(out.getPixelColor(3).r() == 255 * (255 - fade) / 255, "decay fades by amount");
+
+        for (int frame = 0; frame < 256; ++frame) {
+            effects.transmit();
+        }
+        check(out.getPixelColor(3) == 0, "decay reaches black");
+        const uint32_t skipped = effects.framesSkipped();
+        effects.transmit();
+        effects.transmit();
+        check(effects.framesSkipped() == skipped + 2, "decay stops sending once black");
+
+        // a still lit frame fades below itself, so it's skipped like any other
+        effects.setPixelColor(5, rgb32_t(200, 100, 50));
+        effects.transmit();
+        const uint32_t sent = effects.framesSent();
+        for (int frame = 0; frame < 10; ++frame) {
+            effects.transmit();
+        }
+        check(effects.framesSent() == sent, "still lit frame is skipped");
+        check(out.getPixelColor(5) == rgb32_t(200, 100, 50), "still lit frame stays lit");
+    }
+}
+
+// bytes for a program
+static std::vector<uint8_t> programBytes(uint16_t duration, std::span<const Pattern::Instruction> code)
+{
+    std::vector<uint8_t> bytes(Pattern::Program::MaxSize);
+    bytes.resize(Pattern::Program::encode(duration, code, bytes));
+    return bytes;
+}
+
+static bool sameProgram(const Pattern::Program& program, uint16_t duration, std::span<const Pattern::Instruction> code)
+{
+    return program.duration() == duration && program.code().size() == code.size()
+        && std::equal(code.begin(), code.end(), program.code().begin(), [](const auto& a, const auto& b) {
+            return a.op == b.op && a.d == b.d && a.a == b.a && a.b == b.b;
+        });
+}
+
+// invalid programs and chunk sets are turned away, leaving the slot's program as it was
+static void checkPrograms()
+{
+    using Pattern::Op;
+    const auto& example(Pattern::ExamplePrograms()[0]);
+
+    // each bad instruction goes in the middle of a good program
+    const Pattern::Instruction bad[] = {
+        {Op::Jump, 0, 0, 0},        // backward
+        {Op::Jump, 0, 0, 1},        // to itself
+        {Op::Jump, 0, 0, 4},        // past the end
+        {Op::JumpZero, 0, 8, 0},
+        {Op::JumpNotZero, 0, 16, 3},
+        {Op::Pack, 14, 0, 0},
+        {Op::Pack, 15, 0, 0},
+        {Op::Unpack, 14, 7, 0},
+        {Op::Unpack, 8, 16, 0},
+        {Op::Add, 16, 0, 0},
+        {Op::Add, 8, 16, 0},
+        {Op::Add, 8, 0, 16},
+        {Op::Load, 16, 0, 0},
+        {Op::AddImm, 8, 16, 1},
+        {Op::Count, 0, 0, 0},
+        {Op(255), 0, 0, 0},
+    };
+    Pattern::Program program;
+    check(program.load(programBytes(example.duration, example.code)), "example program loads");
+    int accepted = 0;
+    for (const auto& instruction : bad) {
+        const Pattern::Instruction code[] = {{Op::Move, 8, 0, 0}, instruction, {Op::End, 0, 0, 0}};
+        accepted += program.load(programBytes(500, code));
+    }
+    check(accepted == 0, "programs with bad instructions are rejected");
+
+    // bad headers and sizes
+    const Pattern::Instruction good[] = {{Op::Move, 8, 0, 0}, {Op::Jump, 0, 0, 3}, {Op::End, 0, 0, 0}};
+    check(Pattern::Program().load(programBytes(500, good)), "good program loads");
+    std::vector<std::vector<uint8_t>> headers(7, programBytes(500, good));
+    headers[0][0] = 'X';
+    headers[1][2] = Pattern::Program::Version + 1;
+    headers[2].push_back(0);
+    headers[3].pop_back();
+    headers[4][3] = Pattern::Program::MaxInstructions + 1;
+    headers[5][4] = headers[5][5] = 0;
+    headers[6].resize(Pattern::Program::HeaderSize - 1);
+    for (const auto& bytes : headers) {
+        accepted += program.load(bytes);
+    }
+    check(accepted == 0, "programs with bad headers are rejected");
+    check(sameProgram(program, example.duration, example.code), "rejected programs leave the program as it was");
+
+    // a two chunk program, and the slot holding the example
+    std::vector<Pattern::Instruction> big(Pattern::Program::MaxInstructions - 1, {Op::Move, 8, 0, 0});
+    big.push_back({Op::End, 0, 0, 0});
+    const auto bigBytes(programBytes(1000, big));
+    Pattern::ProgramChunk chunks[Pattern::ProgramStore::MaxChunks], other[Pattern::ProgramStore::MaxChunks];
+    check(Pattern::ProgramStore::split(bigBytes, 1, 7, chunks) == 2, "big program splits in two");
+    Pattern::ProgramStore::split(bigBytes, 1, 8, other);
+
+    // each set goes to a fresh store with the example in the slot
+    const auto exampleBytes(programBytes(example.duration, example.code));
+    Pattern::ProgramChunk first;
+    Pattern::ProgramStore::split(exampleBytes, 1, 1, std::span(&first, 1));
+    auto rejected = [&](std::initializer_list<Pattern::ProgramChunk> sent) {
+        auto store(std::make_unique<Pattern::ProgramStore>());
+        bool loaded = !store->receive(first);
+        for (const auto& chunk : sent) {
+            loaded = store->receive(chunk) || loaded;
+        }
+        return !loaded && sameProgram(store->program(1), example.duration, example.code);
+    };
+    Pattern::ProgramChunk shortChunk(chunks[0]);
+    shortChunk.length = 100;
+    check(rejected({chunks[1], chunks[0]}), "out of order chunks are rejected");
+    check(rejected({chunks[0], chunks[0]}), "duplicated first chunk is rejected");
+    check(rejected({chunks[1], chunks[1]}), "duplicated last chunk is rejected");
+    check(rejected({chunks[0], other[1]}), "chunks mixed across ids are rejected");
+    check(rejected({other[0], chunks[1]}), "chunks mixed across ids are rejected");
+    check(rejected({shortChunk, chunks[1]}), "short non final chunk is rejected");
+    check(!rejected({chunks[0], chunks[1]}), "chunks in order are received");
+
+    auto store(std::make_unique<Pattern::ProgramStore>());
+    check(store->receive(chunks[0]) == false && store->receive(chunks[1]), "big program received");
+    check(!store->receive(chunks[1]), "chunk repeated after completing is rejected");
+    check(sameProgram(store->program(1), 1000, big), "big program round trips");
+
+    // every example round trips through encode, split and receive
+    for (const auto& entry : Pattern::ExamplePrograms()) {
+        const auto bytes(programBytes(entry.duration, entry.code));
+        size_t count = Pattern::ProgramStore::split(bytes, 2, 9, chunks);
+        bool loaded = false;
+        for (size_t i = 0; i < count; ++i) {
+            loaded = store->receive(chunks[i]);
+        }
+        check(loaded && sameProgram(store->program(2), entry.duration, entry.code), entry.name);
+    }
+}
+
+// a strip that doesn't keep its pixels in memory, only per pixel access
+class PixelStrip : public Pattern::Strip
+{
+public:
+    PixelStrip(uint16_t size) : m_pixels(size) {}
+    uint16_t numPixels() const override { return m_pixels.size(); }
+    rgb32_t getPixelColor(uint16_t pixel) const override { return m_pixels[pixel]; }
+    void setPixelColor(uint16_t pixel, rgb32_t color) override { m_pixels[pixel] = color; }
+    uint8_t getBrightness() const override { return 255; }
+    void setBrightness(uint8_t) override {}
+    void transmit() override {}
+
+    std::vector<rgb32_t> m_pixels;
+};
+
+// patterns render the same onto strips with and without pixels in memory
+static void checkPixelStrip()
+{
+    for (uint8_t pattern : {Pattern::MiniTwinkle, Pattern::Rainbow, Pattern::Wipe}) {
+        Pattern::BufferStrip buffered(60);
+        PixelStrip unbuffered(60);
+        Pattern::Player a, b;
+        Pattern::PlayerControl control{255, pattern, 100,
+            {rgb24_t::Red(), rgb24_t::White(), rgb24_t::Green()}};
+        a.UpdatePattern(0, control, &buffered);
+        b.UpdatePattern(0, control, &unbuffered);
+        bool same = true;
+        for (Pattern::ms_t now = 0; now < 2000; now += 25) {
+            a.UpdateStrip(now, &buffered);
+            b.UpdateStrip(now, &unbuffered);
+            same = same && std::equal(unbuffered.m_pixels.begin(), unbuffered.m_pixels.end(), buffered.pixels().begin());
+        }
+        check(same, "pattern renders the same without strip pixels");
+    }
+}
+
+int main()
+{
+    checkFrameKernels();
+    checkGradient();
+    checkWhiteFromEmitters();
+    checkEncoder();
+    checkPowerLimiter();
+    checkCompositeMap();
+    checkCompositeDone();
+    checkPixelStrip();
+    checkPrograms();
+    checkDecay();
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,351 @@
+/*
+RadioPixel host player
+
+Runs patterns through a Player on a HostStrip at simulated time, as fast as
+possible, and reports the render cost and a hash of the frames produced.
+The example bytecode programs are loaded into the program slots and run
+after the built in patterns.
+An overlay pattern can be layered on top of each pattern with a Compositor.
+With a transition time the Player crossfades back and forth between each
+pattern and the next one, so every frame is mid-transition.
+With a matrix width the pixels are mapped as a serpentine matrix, for the
+patterns that work across space.
+Effects run each frame through an EffectStrip on its way to the recorded strip,
+and their cost is counted with the render cost.
+With a power budget the frames are also encoded as the ESP32 output does, and
+the estimated current and limiting are reported.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "patterns/Compositor.h"
+#include "patterns/EffectStrip.h"
+#include "patterns/HostStrip.h"
+#include "patterns/PixelMap.h"
+#include "patterns/Player.h"
+#include "patterns/Program.h"
+#include "patterns/WireEncoder.h"
+
+
+struct Options
+{
+    int pattern = -1;           // -1 for all patterns
+    uint16_t pixels = 60;
+    Pattern::ms_t duration = 10000;
+    int refresh_rate = 40;      // Hz
+    Pattern::PlayerControl control{255, 0, 100,
+        {Color::rgb24_t::Red(), Color::rgb24_t::White(), Color::rgb24_t::Green()}};
+    const char *output = nullptr;
+    uint32_t budget = 0;        // mA, 0 for no power estimate
+    int overlay = -1;           // pattern layered on top, -1 for none
+    Pattern::ms_t cache = 0;    // loop cache resolution, 0 for none
+    uint16_t width = 0;         // matrix row length, 0 for a strip
+    std::vector<Pattern::Effect> effects;
+    Pattern::Compositor::Blend blend = Pattern::Compositor::Blend::Add;
+};
+
+struct Result
+{
+    size_t frames = 0;
+    double render_ns = 0;       // total time spent rendering
+    uint64_t hash = 0;          // FNV-1a of every rendered frame
+    uint32_t peak_ma = 0;       // highest estimated current
+    uint16_t min_scale = Pattern::PowerLimiter::Unity; // most the limiter scaled the output
+};
+
+static void usage()
+{
+    fprintf(stderr,
+        "usage: hostplayer [options]\n"
+        "  -p pattern   pattern id or name, default all\n"
+        "  -n pixels    strip length, default 60\n"
+        "  -t ms        simulated run time, default 10000\n"
+        "  -r hz        refresh rate, default 40\n"
+        "  -s speed     speed percent, default 100\n"
+        "  -l level     level[0], default 128\n"
+        "  -i intensity strip brightness, default 255\n"
+        "  -o prefix    record frames to <prefix><pattern>.rpx\n"
+        "  -m mA        estimate current and limit it to a budget\n"
+        "  -L pattern   layer a pattern on top of each pattern\n"
+        "  -b blend     how the layer combines: over, add, max or multiply, default add\n"
+        "  -c ms        play deterministic patterns from a loop cache at this resolution\n"
+        "  -w width     map the pixels as a serpentine matrix with rows this long\n"
+        "  -a axis      axis for patterns across a matrix: 0 x, 1 y, 2 angle, 3 radius\n"
+        "  -e effects   post process frames, eg repeat:60,blur:128 from mirror, reverse,\n"
+        "               repeat:pixels, blur:amount and decay:amount\n"
+        "  -S seed      seed for random patterns, default 0\n"
+        "  -x time      crossfade to the next pattern and back, in 10ms steps\n");
+}
+
+// the built in patterns, then a pattern per example program
+static int lastPattern()
+{
+    return Pattern::Bytecode + Pattern::ExamplePrograms().size() - 1;
+}
+
+static const char *patternName(int id)
+{
+    return (id >= Pattern::Bytecode) ? Pattern::ExamplePrograms()[id - Pattern::Bytecode].name : Pattern::PatternName(id);
+}
+
+// load the example programs the way a node receives them
+static bool loadPrograms()
+{
+    uint8_t slot = 0;
+    for (const auto& example : Pattern::ExamplePrograms())
+    {
+        uint8_t bytes[Pattern::Program::MaxSize];
+        Pattern::ProgramChunk chunks[Pattern::ProgramStore::MaxChunks];
+        size_t size = Pattern::Program::encode(example.duration, example.code, bytes);
+        size_t count = Pattern::ProgramStore::split(std::span(bytes, size), slot, 1, chunks);
+        bool loaded = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            loaded = Pattern::Programs().receive(chunks[i]);
+        }
+        if (!loaded)
+        {
+            fprintf(stderr, "program %s didn't load\n", example.name);
+            return false;
+        }
+        slot++;
+    }
+    return true;
+}
+
+static int parsePattern(const char *arg)
+{
+    for (int id = 0; id <= lastPattern(); ++id)
+    {
+        if (strcmp(arg, patternName(id)) == 0)
+        {
+            return id;
+        }
+    }
+    return (strcmp(arg, "all") == 0) ? -1 : atoi(arg);
+}
+
+static bool parseBlend(const char *arg, Pattern::Compositor::Blend& blend)
+{
+    const char *names[] = {"over", "add", "max", "multiply"};
+    for (size_t i = 0; i < std::size(names); ++i)
+    {
+        if (strcmp(arg, names[i]) == 0)
+        {
+            blend = static_cast<Pattern::Compositor::Blend>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseEffects(const char *arg, std::vector<Pattern::Effect>& effects)
+{
+    const char *names[] = {"none", "mirror", "reverse", "repeat", "blur", "decay"};
+    std::string list(arg);
+    for (size_t start = 0; start <= list.size();)
+    {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string item(list.substr(start, end - start));
+        size_t colon = item.find(':');
+        std::string name(item.substr(0, colon));
+        auto found = std::find_if(std::begin(names), std::end(names), [&](const char *n) { return name == n; });
+        if (found == std::end(names) || effects.size() >= Pattern::EffectStrip::MaxEffects)
+        {
+            return false;
+        }
+        Pattern::Effect effect;
+        effect.type = static_cast<Pattern::Effect::Type>(found - std::begin(names));
+        effect.amount = (colon != std::string::npos) ? atoi(item.c_str() + colon + 1) : 0;
+        effects.push_back(effect);
+        start = end + 1;
+    }
+    return true;
+}
+
+static Result run(const Options& options, uint8_t pattern)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Pattern::HostStrip strip(options.pixels, 0);
+    if (options.output)
+    {
+        std::string path(std::string(options.output) + patternName(pattern) + ".rpx");
+        if (!strip.record(path.c_str()))
+        {
+            fprintf(stderr, "can't create %s\n", path.c_str());
+        }
+    }
+
+    // output as sent to the LEDs, when estimating current
+    Pattern::WireEncoder encoder;
+    encoder.setGamma(2.2f);
+    encoder.limiter().setBudget(options.budget);
+    std::vector<uint8_t> wire(encoder.size(options.pixels));
+
+    // patterns render across the matrix, the output takes it back to wire order
+    auto map(Pattern::PixelMap::Matrix(options.width, options.width ? options.pixels / options.width : 0));
+    if (options.width)
+    {
+        strip.setPixelMap(&map);
+        encoder.setOrder(Pattern::PixelMap::Serpentine(options.width, options.pixels / options.width));
+    }
+
+    // patterns render into the effects when there are any
+    Pattern::EffectStrip effects(&strip);
+    effects.setEffects(options.effects);
+    if (effects.numPixels() == strip.numPixels())
+    {
+        // the layout only fits when no effect shrinks the strip
+        effects.setPixelMap(strip.pixelMap());
+    }
+    Pattern::Strip *target = options.effects.empty() ? static_cast<Pattern::Strip *>(&strip) : &effects;
+
+    // the pattern, or layers of the pattern and the overlay
+    Pattern::Player player;
+    Pattern::Compositor compositor(2);
+    auto control(options.control);
+    control.pattern = pattern;
+    if (options.overlay < 0)
+    {
+        player.setLoopCache(options.cache, SIZE_MAX);
+        player.UpdatePattern(0, control, target);
+    }
+    else
+    {
+        target->setBrightness(control.intensity);
+        control.intensity = 255;
+        compositor.UpdateLayer(0, 0, control, Pattern::Compositor::Blend::Over, target);
+        control.pattern = options.overlay;
+        compositor.UpdateLayer(1, 0, control, options.blend, target);
+    }
+
+    // switching patterns as each crossfade ends keeps the player transitioning
+    const Pattern::ms_t transition = control.transition * 10;
+    Pattern::ms_t nextSwitch = 0;
+    int switches = 0;
+
+    Result result;
+    result.hash = 14695981039346656037ull;
+    const Pattern::ms_t period = 1000 / options.refresh_rate;
+    for (Pattern::ms_t now = 0; now < options.duration; now += period)
+    {
+        auto start(Clock::now());
+        if (options.overlay < 0)
+        {
+            if (transition && now >= nextSwitch)
+            {
+                control.pattern = (++switches & 1) ? (pattern + 1) % (lastPattern() + 1) : pattern;
+                player.UpdatePattern(now, control, target);
+                nextSwitch = now + transition;
+            }
+            player.UpdateStrip(now, target);
+        }
+        else
+        {
+            compositor.UpdateStrip(now, target);
+        }
+        strip.setTime(now);
+        if (target != &strip)
+        {
+            target->transmit();
+        }
+        result.render_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        for (auto pixel : strip.pixels())
+        {
+            result.hash = (result.hash ^ pixel.packed) * 1099511628211ull;
+        }
+        if (options.budget)
+        {
+            encoder.setBrightness(strip.getBrightness());
+            encoder.encode(strip.pixels(), wire.data());
+            result.peak_ma = std::max(result.peak_ma, encoder.limiter().current());
+            result.min_scale = std::min(result.min_scale, encoder.limiter().scale());
+        }
+        if (target == &strip)
+        {
+            strip.transmit();
+        }
+        result.frames++;
+    }
+    strip.close();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:n:t:r:s:l:i:o:m:L:b:x:S:c:w:a:e:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': options.pattern = parsePattern(optarg); break;
+        case 'n': options.pixels = atoi(optarg); break;
+        case 't': options.duration = atoi(optarg); break;
+        case 'r': options.refresh_rate = atoi(optarg); break;
+        case 's': options.control.speed = atoi(optarg); break;
+        case 'l': options.control.level[0] = atoi(optarg); break;
+        case 'i': options.control.intensity = atoi(optarg); break;
+        case 'o': options.output = optarg; break;
+        case 'm': options.budget = atoi(optarg); break;
+        case 'L': options.overlay = parsePattern(optarg); break;
+        case 'x': options.control.transition = atoi(optarg); break;
+        case 'c': options.cache = atoi(optarg); break;
+        case 'w': options.width = atoi(optarg); break;
+        case 'a': options.control.level[1] = (atoi(optarg) & 3) * 64; break;
+        case 'S': options.control.seed = strtoul(optarg, nullptr, 0); break;
+        case 'e':
+            if (!parseEffects(optarg, options.effects))
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 'b':
+            if (!parseBlend(optarg, options.blend))
+            {
+                usage();
+                return 1;
+            }
+            break;
+        default: usage(); return 1;
+        }
+    }
+    if (!options.pixels || options.refresh_rate <= 0 || (options.width && options.pixels % options.width))
+    {
+        usage();
+        return 1;
+    }
+
+    printf("%-12s %8s %8s %12s %10s %18s", "pattern", "pixels", "frames", "ns/frame", "ns/pixel", "hash");
+    printf(options.budget ? " %8s %6s\n" : "\n", "peak mA", "scale");
+    if (!loadPrograms())
+    {
+        return 1;
+    }
+
+    for (int id = 0; id <= lastPattern(); ++id)
+    {
+        if (options.pattern != -1 && options.pattern != id)
+        {
+            continue;
+        }
+        auto result(run(options, id));
+        double perFrame = result.frames ? result.render_ns / result.frames : 0;
+        printf("%-12s %8u %8zu %12.0f %10.2f   %016llx", patternName(id), options.pixels,
+            result.frames, perFrame, perFrame / options.pixels, (unsigned long long)result.hash);
+        if (options.budget)
+        {
+            printf(" %8u %6.2f", result.peak_ma, result.min_scale / double(Pattern::PowerLimiter::Unity));
+        }
+        printf("\n");
+    }
+    return 0;
+}
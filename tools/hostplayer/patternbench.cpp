@@ -0,0 +1,140 @@
+/*
+RadioPixel pattern benchmark
+
+Times every pattern, and the example bytecode programs, through Init, Loop
+and Update at each standard strip size, speed and level, and prints the
+results as CSV for tracking regressions.  The ESP32 build prints the same
+columns in cycles when built with PATTERN_BENCHMARK.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+#include "color/RGB.h"
+#include "patterns/Benchmark.h"
+#include "patterns/Program.h"
+#include "patterns/WireEncoder.h"
+
+
+static uint64_t nanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void usage()
+{
+    fprintf(stderr,
+        "usage: patternbench [options]\n"
+        "  -f frames    frames per run, default 400\n"
+        "  -p pattern   only this pattern id\n"
+        "  -n pixels    only this strip size\n"
+        "  -e           time the wire encoder, encode() against encodeDithered()\n");
+}
+
+// times each wire format with and without dithering, at gamma 2.2 like the boards
+static void benchEncoder(uint32_t frames, int pixels)
+{
+    printf("pixels,format,frames,encode_ns_per_frame,dithered_ns_per_frame,encode_ns_per_pixel,dithered_ns_per_pixel\n");
+    for (auto size : Pattern::Benchmark::Sizes)
+    {
+        if (pixels && size != pixels)
+        {
+            continue;
+        }
+        std::vector<Color::rgb32_t> frame(size);
+        for (size_t i = 0; i < frame.size(); ++i)
+        {
+            frame[i] = Color::ColorWheel(uint8_t(i * 7));
+        }
+        for (auto format : {Pattern::WireFormat::GRB, Pattern::WireFormat::GRBW})
+        {
+            Pattern::WireEncoder encoder(format);
+            encoder.setGamma(2.2f);
+            std::vector<uint8_t> out(encoder.size(size)), residual(encoder.size(size));
+
+            uint64_t start = nanoseconds();
+            for (uint32_t f = 0; f < frames; ++f)
+            {
+                encoder.encode(frame, out.data());
+            }
+            double plain = double(nanoseconds() - start) / frames;
+
+            encoder.setDither(true);
+            start = nanoseconds();
+            for (uint32_t f = 0; f < frames; ++f)
+            {
+                encoder.encodeDithered(frame, residual.data(), out.data());
+            }
+            double dithered = double(nanoseconds() - start) / frames;
+
+            printf("%u,%s,%u,%.1f,%.1f,%.3f,%.3f\n", size, (format == Pattern::WireFormat::GRB) ? "GRB" : "GRBW",
+                frames, plain, dithered, plain / size, dithered / size);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t frames = 400;
+    int only = -1, pixels = 0;
+    bool encoder = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:p:n:eh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': frames = atoi(optarg); break;
+        case 'p': only = atoi(optarg); break;
+        case 'n': pixels = atoi(optarg); break;
+        case 'e': encoder = true; break;
+        default: usage(); return 1;
+        }
+    }
+
+    if (encoder)
+    {
+        benchEncoder(frames, pixels);
+        return 0;
+    }
+
+    // the example programs in the first slots
+    uint8_t slot = 0;
+    for (const auto& example : Pattern::ExamplePrograms())
+    {
+        uint8_t bytes[Pattern::Program::MaxSize];
+        size_t size = Pattern::Program::encode(example.duration, example.code, bytes);
+        Pattern::Programs().program(slot++).load(std::span(bytes, size));
+    }
+
+    Pattern::Benchmark benchmark(nanoseconds);
+    printf("pattern,name,pixels,speed,level,frames,init_ns,ns_per_frame,ns_per_pixel\n");
+    for (int pattern = 0; pattern < Pattern::Bytecode + Pattern::ProgramStore::Slots; ++pattern)
+    {
+        if (!Pattern::Benchmark::available(pattern) || (only >= 0 && pattern != only))
+        {
+            continue;
+        }
+        const char *name = (pattern >= Pattern::Bytecode)
+            ? Pattern::ExamplePrograms()[pattern - Pattern::Bytecode].name : Pattern::PatternName(pattern);
+        for (auto size : Pattern::Benchmark::Sizes)
+        {
+            if (pixels && size != pixels)
+            {
+                continue;
+            }
+            for (auto speed : Pattern::Benchmark::Speeds)
+            {
+                for (auto level : Pattern::Benchmark::Levels)
+                {
+                    auto result(benchmark.run({uint8_t(pattern), size, speed, level}, frames));
+                    printf("%d,%s,%u,%u,%u,%u,%llu,%.1f,%.3f\n", pattern, name, size, speed, level,
+                        result.frames, (unsigned long long)result.init, result.perFrame(), result.perPixel());
+                }
+            }
+        }
+    }
+    return 0;
+}